@@ -17,16 +17,24 @@
     #endif /* SLIC3R_GUI */
 #endif /* WIN32 */
 
+#include <chrono>
+#include <iomanip>
+#include <map>
+#include <mutex>
+
 #include <boost/algorithm/string/predicate.hpp>
+#include <boost/algorithm/string/trim.hpp>
 #include <boost/filesystem.hpp>
 #include <boost/nowide/args.hpp>
 #include <boost/nowide/cenv.hpp>
 #include <boost/nowide/iostream.hpp>
 #include <boost/nowide/integration/filesystem.hpp>
+#include <boost/tokenizer.hpp>
 
 #include "unix/fhs.hpp"  // Generated by CMake from ../platform/unix/fhs.hpp.in
 
 #include "libslic3r/libslic3r.h"
+#include "libslic3r/Channel.hpp"
 #include "libslic3r/Config.hpp"
 #include "libslic3r/Geometry.hpp"
 #include "libslic3r/GCode/PostProcessor.hpp"
@@ -35,6 +43,7 @@
 #include "libslic3r/Platform.hpp"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/SLAPrint.hpp"
+#include "libslic3r/SliceCache.hpp"
 #include "libslic3r/TriangleMesh.hpp"
 #include "libslic3r/Format/AMF.hpp"
 #include "libslic3r/Format/3mf.hpp"
@@ -211,28 +220,8 @@ int CLI::run(int argc, char **argv)
     // Normalizing after importing the 3MFs / AMFs
     m_print_config.normalize_fdm();
 
-    // Initialize full print configs for both the FFF and SLA technologies.
-    FullPrintConfig    fff_print_config;
-    SLAFullPrintConfig sla_print_config;
-    
     // Synchronize the default parameters and the ones received on the command line.
-    if (printer_technology == ptFFF) {
-        fff_print_config.apply(m_print_config, true);
-        m_print_config.apply(fff_print_config, true);
-    } else if (printer_technology == ptSLA) {
-        // The default value has to be different from the one in fff mode.
-        sla_print_config.printer_technology.value = ptSLA;
-        sla_print_config.output_filename_format.value = "[input_filename_base].sl1";
-        
-        // The default bed shape should reflect the default display parameters
-        // and not the fff defaults.
-        double w = sla_print_config.display_width.getFloat();
-        double h = sla_print_config.display_height.getFloat();
-        sla_print_config.bed_shape.values = { Vec2d(0, 0), Vec2d(w, 0), Vec2d(w, h), Vec2d(0, h) };
-        
-        sla_print_config.apply(m_print_config, true);
-        m_print_config.apply(sla_print_config, true);
-    }
+    apply_print_config_defaults(m_print_config, printer_technology);
     
     std::string validity = m_print_config.validate();
     if (!validity.empty()) {
@@ -278,26 +267,13 @@ int CLI::run(int argc, char **argv)
             std::vector<int> &ints = m_config.option<ConfigOptionInts>("duplicate_grid")->values;
             const int x = ints.size() > 0 ? ints.at(0) : 1;
             const int y = ints.size() > 1 ? ints.at(1) : 1;
-            const double distance = fff_print_config.duplicate_distance.value;
+            const double distance = printer_technology == ptFFF ? m_print_config.opt_float("duplicate_distance") : 0.;
             for (auto &model : m_models)
                 model.duplicate_objects_grid(x, y, (distance > 0) ? distance : 6);  // TODO: this is not the right place for setting a default
         } else if (opt_key == "center") {
         	user_center_specified = true;
-            for (auto &model : m_models) {
-                model.add_default_instances();
-                // this affects instances:
-                model.center_instances_around_point(m_config.option<ConfigOptionPoint>("center")->value);
-                // this affects volumes:
-                //FIXME Vojtech: Who knows why the complete model should be aligned with Z as a single rigid body?
-                //model.align_to_ground();
-                BoundingBoxf3 bbox;
-                for (ModelObject *model_object : model.objects)
-                    // We are interested into the Z span only, therefore it is sufficient to measure the bounding box of the 1st instance only.
-                    bbox.merge(model_object->instance_bounding_box(0, false));
-                for (ModelObject *model_object : model.objects)
-                    for (ModelInstance *model_instance : model_object->instances)
-                        model_instance->set_offset(Z, model_instance->get_offset(Z) - bbox.min.z());
-            }
+            for (auto &model : m_models)
+                center_model(model, m_config.option<ConfigOptionPoint>("center")->value);
         } else if (opt_key == "align_xy") {
             const Vec2d &p = m_config.option<ConfigOptionPoint>("align_xy")->value;
             for (auto &model : m_models) {
@@ -442,6 +418,9 @@ int CLI::run(int argc, char **argv)
         } else if (opt_key == "export_3mf") {
             if (! this->export_models(IO::TMF))
                 return 1;
+        } else if (opt_key == "batch") {
+            if (! this->run_batch(printer_technology, config_substitution_rule))
+                return 1;
         } else if (opt_key == "export_gcode" || opt_key == "export_sla" || opt_key == "slice") {
             if (opt_key == "export_gcode" && printer_technology == ptSLA) {
                 boost::nowide::cerr << "error: cannot export G-code for an FFF configuration" << std::endl;
@@ -458,93 +437,8 @@ int CLI::run(int argc, char **argv)
                 if (make_copy)
                     model_copy = model_in;
                 Model &model = make_copy ? model_copy : model_in;
-                // If all objects have defined instances, their relative positions will be
-                // honored when printing (they will be only centered, unless --dont-arrange
-                // is supplied); if any object has no instances, it will get a default one
-                // and all instances will be rearranged (unless --dont-arrange is supplied).
-                std::string outfile = m_config.opt_string("output");
-                Print       fff_print;
-                SLAPrint    sla_print;
-                std::shared_ptr<SLAArchive> sla_archive = Slic3r::get_output_format(m_print_config);
-
-                sla_print.set_printer(sla_archive);
-                sla_print.set_status_callback(
-                            [](const PrintBase::SlicingStatus& s)
-                {
-                    if(s.percent >= 0 && s.args.empty()) // FIXME: is this sufficient?
-                        printf("%3d%s %s\n", s.percent, "% =>", s.main_text.c_str());
-                });
-
-                PrintBase  *print = (printer_technology == ptFFF) ? static_cast<PrintBase*>(&fff_print) : static_cast<PrintBase*>(&sla_print);
-                
-                if (! m_config.opt_bool("dont_arrange")) {
-                    ArrangeParams arrange_cfg;
-                    arrange_cfg.min_obj_distance = scaled(PrintConfig::min_object_distance(&m_print_config)) * 2;
-                    if(m_print_config.option("duplicate_distance") != nullptr)
-                        arrange_cfg.min_obj_distance += scaled(m_print_config.opt_float("duplicate_distance"));
-                    else
-                        arrange_cfg.min_obj_distance += 6;
-                    if (dups > 1) {
-                            try {
-                            // if all input objects have defined position(s) apply duplication to the whole model
-                            duplicate(model, size_t(dups), bed, arrange_cfg);
-                        } catch (std::exception & ex) {
-                            boost::nowide::cerr << "error: " << ex.what() << std::endl;
-                            return 1;
-                        }
-                    }
-                    if (user_center_specified) {
-                        Vec2d c = m_config.option<ConfigOptionPoint>("center")->value;
-                        arrange_objects(model, InfiniteBed{scaled(c)}, arrange_cfg);
-                    } else
-                        arrange_objects(model, bed, arrange_cfg);
-                }
-                if (printer_technology == ptFFF) {
-                    for (auto* mo : model.objects)
-                        fff_print.auto_assign_extruders(mo);
-                } else {
-                    // The default for "output_filename_format" is good for FDM: "[input_filename_base].gcode"
-                    // Replace it with a reasonable SLA default.
-                    std::string &format = m_print_config.opt_string("output_filename_format", true);
-                    if (format == static_cast<const ConfigOptionString*>(m_print_config.def()->get("output_filename_format")->default_value.get())->value)
-                        format = "[input_filename_base].SL1";
-                }
-                print->apply(model, m_print_config);
-                std::pair<PrintBase::PrintValidationError, std::string> err = print->validate();
-                if (err.first != PrintBase::PrintValidationError::pveNone) {
-                    boost::nowide::cerr << err.second << std::endl;
+                if (! slice_model(model, m_print_config, m_config, printer_technology, dups, bed, user_center_specified))
                     return 1;
-                }
-                if (print->empty())
-                    boost::nowide::cout << "Nothing to print for " << outfile << " . Either the print is empty or no object is fully inside the print volume." << std::endl;
-                else
-                    try {
-                        std::string outfile_final;
-                        print->process();
-                        if (printer_technology == ptFFF) {
-                            // The outfile is processed by a PlaceholderParser.
-                            outfile = fff_print.export_gcode(outfile, nullptr, nullptr);
-                            outfile_final = fff_print.print_statistics().finalize_output_path(outfile);
-                        } else if (printer_technology == ptSLA) {
-                            outfile = sla_print.output_filepath(outfile);
-                            // We need to finalize the filename beforehand because the export function sets the filename inside the zip metadata
-                            outfile_final = sla_print.print_statistics().finalize_output_path(outfile);
-                            sla_archive->export_print(outfile_final, sla_print);
-                        }
-                        if (outfile != outfile_final) {
-                            if (Slic3r::rename_file(outfile, outfile_final)) {
-                                boost::nowide::cerr << "Renaming file " << outfile << " to " << outfile_final << " failed" << std::endl;
-                                return 1;
-                            }
-                            outfile = outfile_final;
-                        }
-                        // Run the post-processing scripts if defined.
-                        run_post_process_scripts(outfile, fff_print.full_print_config());
-                        boost::nowide::cout << "Slicing result exported to " << outfile << std::endl;
-                    } catch (const std::exception &ex) {
-                        boost::nowide::cerr << ex.what() << std::endl;
-                        return 1;
-                    }
 /*
                 print.center = ! m_config.has("center")
                     && ! m_config.has("align_xy")
@@ -603,6 +497,363 @@ int CLI::run(int argc, char **argv)
     return 0;
 }
 
+void CLI::apply_print_config_defaults(DynamicPrintConfig &print_config, PrinterTechnology printer_technology)
+{
+    // Initialize full print configs for both the FFF and SLA technologies.
+    if (printer_technology == ptFFF) {
+        FullPrintConfig fff_print_config;
+        fff_print_config.apply(print_config, true);
+        print_config.apply(fff_print_config, true);
+    } else if (printer_technology == ptSLA) {
+        SLAFullPrintConfig sla_print_config;
+        // The default value has to be different from the one in fff mode.
+        sla_print_config.printer_technology.value = ptSLA;
+        sla_print_config.output_filename_format.value = "[input_filename_base].sl1";
+        
+        // The default bed shape should reflect the default display parameters
+        // and not the fff defaults.
+        double w = sla_print_config.display_width.getFloat();
+        double h = sla_print_config.display_height.getFloat();
+        sla_print_config.bed_shape.values = { Vec2d(0, 0), Vec2d(w, 0), Vec2d(w, h), Vec2d(0, h) };
+        
+        sla_print_config.apply(print_config, true);
+        print_config.apply(sla_print_config, true);
+    }
+}
+
+void CLI::center_model(Model &model, const Vec2d &center)
+{
+    model.add_default_instances();
+    // this affects instances:
+    model.center_instances_around_point(center);
+    // this affects volumes:
+    //FIXME Vojtech: Who knows why the complete model should be aligned with Z as a single rigid body?
+    //model.align_to_ground();
+    BoundingBoxf3 bbox;
+    for (ModelObject *model_object : model.objects)
+        // We are interested into the Z span only, therefore it is sufficient to measure the bounding box of the 1st instance only.
+        bbox.merge(model_object->instance_bounding_box(0, false));
+    for (ModelObject *model_object : model.objects)
+        for (ModelInstance *model_instance : model_object->instances)
+            model_instance->set_offset(Z, model_instance->get_offset(Z) - bbox.min.z());
+}
+
+bool CLI::slice_model(Model &model, DynamicPrintConfig &print_config, const DynamicPrintAndCLIConfig &cli_config, PrinterTechnology printer_technology,
+    int dups, const Points &bed, bool user_center_specified, size_t job_id)
+{
+    // If all objects have defined instances, their relative positions will be
+    // honored when printing (they will be only centered, unless --dont-arrange
+    // is supplied); if any object has no instances, it will get a default one
+    // and all instances will be rearranged (unless --dont-arrange is supplied).
+    std::string outfile = cli_config.opt_string("output");
+    Print       fff_print;
+    SLAPrint    sla_print;
+    std::shared_ptr<SLAArchive> sla_archive = Slic3r::get_output_format(print_config);
+
+    sla_print.set_printer(sla_archive);
+    sla_print.set_status_callback(
+                [job_id](const PrintBase::SlicingStatus& s)
+    {
+        if(s.percent >= 0 && s.args.empty()) { // FIXME: is this sufficient?
+            // The jobs of --batch report their status concurrently.
+            static std::mutex status_mutex;
+            std::lock_guard<std::mutex> lock(status_mutex);
+            if (job_id > 0)
+                printf("Job %zu: ", job_id);
+            printf("%3d%s %s\n", s.percent, "% =>", s.main_text.c_str());
+        }
+    });
+
+    PrintBase  *print = (printer_technology == ptFFF) ? static_cast<PrintBase*>(&fff_print) : static_cast<PrintBase*>(&sla_print);
+    
+    if (! cli_config.opt_bool("dont_arrange")) {
+        ArrangeParams arrange_cfg;
+        arrange_cfg.min_obj_distance = scaled(PrintConfig::min_object_distance(&print_config)) * 2;
+        if(print_config.option("duplicate_distance") != nullptr)
+            arrange_cfg.min_obj_distance += scaled(print_config.opt_float("duplicate_distance"));
+        else
+            arrange_cfg.min_obj_distance += 6;
+        if (dups > 1) {
+                try {
+                // if all input objects have defined position(s) apply duplication to the whole model
+                duplicate(model, size_t(dups), bed, arrange_cfg);
+            } catch (std::exception & ex) {
+                boost::nowide::cerr << "error: " << ex.what() << std::endl;
+                return false;
+            }
+        }
+        if (user_center_specified) {
+            Vec2d c = cli_config.option<ConfigOptionPoint>("center")->value;
+            arrange_objects(model, InfiniteBed{scaled(c)}, arrange_cfg);
+        } else
+            arrange_objects(model, bed, arrange_cfg);
+    }
+    if (printer_technology == ptFFF) {
+        if (const std::string &slice_cache_dir = cli_config.opt_string("slice_cache"); ! slice_cache_dir.empty())
+            fff_print.set_slice_cache(std::make_shared<SliceCache>(slice_cache_dir));
+        for (auto* mo : model.objects)
+            fff_print.auto_assign_extruders(mo);
+    } else {
+        // The default for "output_filename_format" is good for FDM: "[input_filename_base].gcode"
+        // Replace it with a reasonable SLA default.
+        std::string &format = print_config.opt_string("output_filename_format", true);
+        if (format == static_cast<const ConfigOptionString*>(print_config.def()->get("output_filename_format")->default_value.get())->value)
+            format = "[input_filename_base].SL1";
+    }
+    print->apply(model, print_config);
+    std::pair<PrintBase::PrintValidationError, std::string> err = print->validate();
+    if (err.first != PrintBase::PrintValidationError::pveNone) {
+        boost::nowide::cerr << err.second << std::endl;
+        return false;
+    }
+    if (print->empty())
+        boost::nowide::cout << "Nothing to print for " << outfile << " . Either the print is empty or no object is fully inside the print volume." << std::endl;
+    else
+        try {
+            std::string outfile_final;
+            print->process();
+            if (printer_technology == ptFFF) {
+                // The outfile is processed by a PlaceholderParser.
+                outfile = fff_print.export_gcode(outfile, nullptr, nullptr);
+                outfile_final = fff_print.print_statistics().finalize_output_path(outfile);
+            } else if (printer_technology == ptSLA) {
+                outfile = sla_print.output_filepath(outfile);
+                // We need to finalize the filename beforehand because the export function sets the filename inside the zip metadata
+                outfile_final = sla_print.print_statistics().finalize_output_path(outfile);
+                sla_archive->export_print(outfile_final, sla_print);
+            }
+            if (outfile != outfile_final) {
+                if (Slic3r::rename_file(outfile, outfile_final)) {
+                    boost::nowide::cerr << "Renaming file " << outfile << " to " << outfile_final << " failed" << std::endl;
+                    return false;
+                }
+                outfile = outfile_final;
+            }
+            // Run the post-processing scripts if defined.
+            run_post_process_scripts(outfile, fff_print.full_print_config());
+            boost::nowide::cout << "Slicing result exported to " << outfile << std::endl;
+        } catch (const std::exception &ex) {
+            boost::nowide::cerr << ex.what() << std::endl;
+            return false;
+        }
+
+    return true;
+}
+
+// Configs loaded with --load by the batch jobs, shared by all the jobs, so that each config file is parsed only once.
+class CLI::BatchConfigCache
+{
+public:
+    BatchConfigCache(ForwardCompatibilitySubstitutionRule substitution_rule) : m_substitution_rule(substitution_rule) {}
+
+    // Throws if the file cannot be loaded.
+    const DynamicPrintConfig& load(const std::string &file)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_configs.find(file);
+        if (it == m_configs.end()) {
+            DynamicPrintConfig config;
+            config.load(file, m_substitution_rule);
+            config.normalize_fdm();
+            it = m_configs.emplace(file, std::move(config)).first;
+        }
+        // std::map does not invalidate references on insertion, the configs are never modified once loaded.
+        return it->second;
+    }
+
+private:
+    ForwardCompatibilitySubstitutionRule            m_substitution_rule;
+    std::mutex                                      m_mutex;
+    std::map<std::string, DynamicPrintConfig>       m_configs;
+};
+
+namespace {
+    // Split a job line into command line arguments. Arguments containing spaces may be quoted.
+    std::vector<std::string> split_batch_job(const std::string &line)
+    {
+        std::vector<std::string> args;
+        boost::tokenizer<boost::escaped_list_separator<char>> tokens(line, boost::escaped_list_separator<char>("", " \t", "\"'"));
+        for (const std::string &token : tokens)
+            if (! token.empty())
+                args.emplace_back(token);
+        return args;
+    }
+
+    struct BatchJob
+    {
+        size_t      id { 0 };
+        std::string line;
+        // Empty job to stop a worker.
+        bool        stop { false };
+    };
+}
+
+// Slice the jobs read from the standard input, one job per line, until the end of the input or until a "quit" line.
+// Each job is written with the command line syntax: the input files, --output, --load and the config overrides.
+// The jobs are applied over the configuration and the CLI options of the batch process, which are loaded and validated only once,
+// and up to --batch-jobs jobs are sliced concurrently, sharing the TBB worker threads.
+bool CLI::run_batch(PrinterTechnology printer_technology, ForwardCompatibilitySubstitutionRule config_substitution_rule) const
+{
+    const size_t     num_workers = size_t(std::max(1, m_config.opt_int("batch_jobs")));
+    BatchConfigCache config_cache(config_substitution_rule);
+    Channel<BatchJob> queue;
+    std::mutex       output_mutex;
+    size_t           num_failed = 0;
+
+    auto worker = [&]() {
+        for (;;) {
+            BatchJob job = queue.pop();
+            if (job.stop)
+                break;
+            auto   t_start = std::chrono::steady_clock::now();
+            bool   success = false;
+            try {
+                success = this->run_batch_job(job.id, job.line, printer_technology, config_substitution_rule, config_cache);
+            } catch (const std::exception &ex) {
+                boost::nowide::cerr << "Job " << job.id << ": " << ex.what() << std::endl;
+            }
+            double duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+            std::lock_guard<std::mutex> lock(output_mutex);
+            if (! success)
+                ++ num_failed;
+            boost::nowide::cout << "Job " << job.id << (success ? " done" : " failed") << " in " << std::fixed << std::setprecision(3) << duration << " s: " << job.line << std::endl;
+        }
+    };
+
+    std::vector<boost::thread> workers;
+    workers.reserve(num_workers);
+    for (size_t i = 0; i < num_workers; ++ i)
+        workers.emplace_back(create_thread(worker));
+
+    size_t      num_jobs = 0;
+    std::string line;
+    while (std::getline(boost::nowide::cin, line)) {
+        boost::algorithm::trim(line);
+        if (line.empty() || line.front() == '#')
+            continue;
+        if (line == "quit")
+            break;
+        queue.push(BatchJob{ ++ num_jobs, line, false });
+    }
+    for (size_t i = 0; i < num_workers; ++ i)
+        queue.push(BatchJob{ 0, std::string(), true });
+    for (boost::thread &thread : workers)
+        thread.join();
+
+    boost::nowide::cout << "Batch finished: " << num_jobs - num_failed << " of " << num_jobs << " jobs succeeded." << std::endl;
+    return num_failed == 0;
+}
+
+bool CLI::run_batch_job(size_t job_id, const std::string &line, PrinterTechnology printer_technology, ForwardCompatibilitySubstitutionRule config_substitution_rule, BatchConfigCache &config_cache) const
+{
+    DynamicPrintAndCLIConfig  job_config;
+    std::vector<std::string>  input_files;
+    t_config_option_keys      opt_order;
+    std::vector<std::string>  args = split_batch_job(line);
+    // read_cli() skips the executable name.
+    std::vector<const char*>  argv { "" };
+    for (const std::string &arg : args)
+        argv.emplace_back(arg.c_str());
+    if (! job_config.read_cli(int(argv.size()), argv.data(), &input_files, &opt_order))
+        return false;
+    for (auto const &opt_key : opt_order)
+        if (cli_actions_config_def.has(opt_key) || (cli_transform_config_def.has(opt_key) && 
+            opt_key != "center" && opt_key != "dont_arrange" && opt_key != "duplicate")) {
+            boost::nowide::cerr << "error: option not supported in batch mode: " << opt_key << std::endl;
+            return false;
+        }
+    if (input_files.empty()) {
+        boost::nowide::cerr << "error: no input file" << std::endl;
+        return false;
+    }
+    std::string validity = job_config.validate();
+    if (! validity.empty()) {
+        boost::nowide::cerr << "error: " << validity << std::endl;
+        return false;
+    }
+    // The overrides of the job have to be extracted before the CLI options are initialized.
+    DynamicPrintConfig job_overrides;
+    job_overrides.apply(job_config, true);
+    job_overrides.normalize_fdm();
+    // The transform and misc options not given by the job are inherited from the batch process (--output, --center, --dont-arrange,
+    // --slice-cache...), the --load files of the batch process are already applied to m_print_config.
+    for (const t_optiondef_map *options : { &cli_transform_config_def.options, &cli_misc_config_def.options })
+        for (const std::pair<t_config_option_key, ConfigOptionDef> &optdef : *options)
+            if (! job_config.has(optdef.first) && optdef.first != "load")
+                job_config.set_key_value(optdef.first, m_config.option(optdef.first)->clone());
+    for (const std::pair<t_config_option_key, ConfigOptionDef> &optdef : cli_actions_config_def.options)
+        job_config.option(optdef.first, true);
+
+    // Each job works out its own printer technology from its command line and its config files, as CLI::run() does.
+    PrinterTechnology job_printer_technology = printer_technology;
+    auto              merge_printer_technology = [&job_printer_technology](const DynamicPrintConfig &config) {
+        PrinterTechnology other_printer_technology = Slic3r::printer_technology(config);
+        if (job_printer_technology == ptUnknown) {
+            job_printer_technology = other_printer_technology;
+        } else if (job_printer_technology != other_printer_technology && other_printer_technology != ptUnknown) {
+            boost::nowide::cerr << "Mixing configurations for FFF and SLA technologies" << std::endl;
+            return false;
+        }
+        return true;
+    };
+    if (! merge_printer_technology(job_overrides))
+        return false;
+
+    // Config values of the 3MF / AMF files have the lowest priority, then the --load files and the config keys of the job.
+    DynamicPrintConfig print_config = m_print_config;
+    std::vector<Model> models;
+    for (const std::string &file : input_files) {
+        DynamicPrintConfig        config;
+        ConfigSubstitutionContext config_substitutions(config_substitution_rule);
+        Model model = Model::read_from_file(file, &config, &config_substitutions, Model::LoadAttribute::AddDefaultInstances);
+        if (! merge_printer_technology(config))
+            return false;
+        if (model.objects.empty()) {
+            boost::nowide::cerr << "Error: file is empty: " << file << std::endl;
+            continue;
+        }
+        print_config.apply(config, true);
+        models.emplace_back(std::move(model));
+    }
+    for (const std::string &file : job_config.option<ConfigOptionStrings>("load", true)->values) {
+        const DynamicPrintConfig &config = config_cache.load(file);
+        if (! merge_printer_technology(config))
+            return false;
+        print_config.apply(config, true);
+    }
+    print_config.apply(job_overrides, true);
+    print_config.normalize_fdm();
+    // A job without any printer technology is an FFF job.
+    if (job_printer_technology == ptUnknown)
+        job_printer_technology = ptFFF;
+    apply_print_config_defaults(print_config, job_printer_technology);
+
+    validity = print_config.validate();
+    if (! validity.empty()) {
+        boost::nowide::cerr << "error: " << validity << std::endl;
+        return false;
+    }
+
+    auto         has_transform = [this, &opt_order](const char *opt_key) {
+        return std::find(opt_order.begin(), opt_order.end(), opt_key) != opt_order.end() ||
+               std::find(m_transforms.begin(), m_transforms.end(), opt_key) != m_transforms.end();
+    };
+    const bool   user_center_specified = has_transform("center");
+    const int    dups = has_transform("duplicate") ? job_config.opt_int("duplicate") : 1;
+    const Points bed  = get_bed_shape(print_config);
+    for (Model &model : models) {
+        if (user_center_specified)
+            center_model(model, job_config.option<ConfigOptionPoint>("center")->value);
+        if (dups > 1)
+            model.add_default_instances();
+        // The print config may be modified by slice_model(), each model gets its own copy.
+        DynamicPrintConfig model_print_config = print_config;
+        if (! slice_model(model, model_print_config, job_config, job_printer_technology, dups, bed, user_center_specified, job_id))
+            return false;
+    }
+    return true;
+}
+
 bool CLI::setup(int argc, char **argv)
 {
     {
@@ -43,6 +43,23 @@ private:
     bool has_print_action() const { return m_config.opt_bool("export_gcode") || m_config.opt_bool("export_sla"); }
     
     std::string output_filepath(const Model &model, IO::ExportFormat format) const;
+
+    /// Completes the print config with the defaults of the full FFF or SLA print config, keeping the values already set.
+    static void apply_print_config_defaults(DynamicPrintConfig &print_config, PrinterTechnology printer_technology);
+
+    /// Centers the instances of the model around a point and drops the model onto the bed, see --center.
+    static void center_model(Model &model, const Vec2d &center);
+
+    /// Arranges, slices and exports a single model. The output path is taken from the "output" option of cli_config.
+    /// job_id prefixes the status lines of a batch job, see --batch, it is zero outside of the batch mode.
+    static bool slice_model(Model &model, DynamicPrintConfig &print_config, const DynamicPrintAndCLIConfig &cli_config, PrinterTechnology printer_technology,
+        int dups, const Points &bed, bool user_center_specified, size_t job_id = 0);
+
+    class BatchConfigCache;
+
+    /// Slices the jobs read from the standard input in a single process, see --batch.
+    bool run_batch(PrinterTechnology printer_technology, ForwardCompatibilitySubstitutionRule config_substitution_rule) const;
+    bool run_batch_job(size_t job_id, const std::string &line, PrinterTechnology printer_technology, ForwardCompatibilitySubstitutionRule config_substitution_rule, BatchConfigCache &config_cache) const;
 };
 
 }
@@ -26,6 +26,9 @@
 #include <math.h>
 #include <assert.h>
 
+#include <algorithm>
+#include <vector>
+
 #include <boost/log/trivial.hpp>
 #include <boost/nowide/cstdio.hpp>
 #include <boost/predef/other/endian.h>
@@ -151,13 +154,25 @@ static bool stl_read(stl_file *stl, FILE *fp, int first_facet, bool first)
     	rewind(fp);
 
   	char normal_buf[3][32];
+  	// Binary facets are read in blocks, as a fread() call per facet is dominated by the stream locking and bookkeeping
+  	// on large (gigabyte) meshes. A block of 64k facets takes 3.2MB.
+  	static constexpr uint32_t binary_facets_per_block = 65536;
+  	std::vector<char> block;
+  	uint32_t          block_begin = first_facet;
+  	uint32_t          block_end   = first_facet;
   	for (uint32_t i = first_facet; i < stl->stats.number_of_facets; ++ i) {
   	  	stl_facet facet;
 
     	if (stl->stats.type == binary) {
-      		// Read a single facet from a binary .STL file. We assume little-endian architecture!
-      		if (fread(&facet, 1, SIZEOF_STL_FACET, fp) != SIZEOF_STL_FACET)
-      			return false;
+      		if (i == block_end) {
+      			block_begin = i;
+      			block_end   = std::min(i + binary_facets_per_block, stl->stats.number_of_facets);
+      			block.resize(size_t(block_end - block_begin) * SIZEOF_STL_FACET);
+      			if (fread(block.data(), SIZEOF_STL_FACET, block_end - block_begin, fp) != block_end - block_begin)
+      				return false;
+      		}
+      		// Copy a single facet from the block, the facets are packed by SIZEOF_STL_FACET. We assume little-endian architecture!
+      		memcpy(&facet, block.data() + size_t(i - block_begin) * SIZEOF_STL_FACET, SIZEOF_STL_FACET);
 #if BOOST_ENDIAN_BIG_BYTE
       		// Convert the loaded little endian data to big endian.
       		stl_internal_reverse_quads((char*)&facet, 48);
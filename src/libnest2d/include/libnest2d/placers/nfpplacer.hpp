@@ -8,6 +8,9 @@
 #include <iterator>
 #include <future>
 #include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
 
 #ifndef NDEBUG
 #include <iostream>
@@ -75,6 +78,86 @@ inline void enumerate(
 
 namespace placers {
 
+/**
+ * A thread safe cache of the no-fit polygons of pairs of shapes.
+ *
+ * The nfp of a stationary and an orbiting shape does not depend on the
+ * position of the orbiting shape and it moves together with the stationary
+ * shape. The cache is keyed by the contours of both shapes relative to their
+ * first vertices, thus an nfp computed once is reused, translated, for any
+ * copies of the same shapes in the same rotations.
+ */
+template<class RawShape> class NfpCache {
+    using Vertex = TPoint<RawShape>;
+    using Coord = TCoord<Vertex>;
+public:
+    using Key = std::vector<Coord>;
+
+    static Key key(const RawShape& stationary, const RawShape& orbiter)
+    {
+        Key ret;
+        ret.reserve(2 * (sl::contourVertexCount(stationary) +
+                         sl::contourVertexCount(orbiter)) + 1);
+        ret.emplace_back(Coord(sl::contourVertexCount(stationary)));
+        for(const RawShape *sh : {&stationary, &orbiter}) {
+            auto first = *sl::cbegin(*sh);
+            for(auto it = sl::cbegin(*sh); it != sl::cend(*sh); ++it) {
+                ret.emplace_back(getX(*it) - getX(first));
+                ret.emplace_back(getY(*it) - getY(first));
+            }
+        }
+        return ret;
+    }
+
+    /// Finds the nfp relative to the first vertex of the stationary shape.
+    bool find(const Key& key, RawShape& nfp) const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = nfps_.find(key);
+        if(it == nfps_.end()) return false;
+        nfp = it->second;
+        return true;
+    }
+
+    void insert(Key&& key, RawShape&& nfp)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        // Don't let an arrangement of many different shapes grow the cache without a limit.
+        if(nfps_.size() >= max_size) nfps_.clear();
+        nfps_.emplace(std::move(key), std::move(nfp));
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        nfps_.clear();
+    }
+
+    size_t size() const
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return nfps_.size();
+    }
+
+    /// Maximum number of the cached nfps.
+    size_t max_size = 100000;
+
+private:
+    struct KeyHash {
+        size_t operator()(const Key& key) const
+        {
+            size_t seed = key.size();
+            for(Coord c : key)
+                seed ^= std::hash<Coord>()(c) + 0x9e3779b9 + (seed << 6) +
+                        (seed >> 2);
+            return seed;
+        }
+    };
+
+    mutable std::mutex mutex_;
+    std::unordered_map<Key, RawShape, KeyHash> nfps_;
+};
+
 template<class RawShape>
 struct NfpPConfig {
 
@@ -169,6 +252,13 @@ struct NfpPConfig {
 
     std::function<void(const ItemGroup &, NfpPConfig &config)> on_preload;
 
+    /**
+     * @brief A cache of the no-fit polygons to share between placers, e.g.
+     * over all the bins of an arrangement. If empty, each placer caches
+     * the no-fit polygons of its own items.
+     */
+    std::shared_ptr<NfpCache<RawShape>> nfp_cache;
+
     NfpPConfig(): rotations({0.0, Pi/2.0, Pi, 3*Pi/2}),
         alignment(Alignment::CENTER), starting_point(Alignment::CENTER) {}
 };
@@ -490,6 +580,9 @@ private:
     // Norming factor for the optimization function
     const double norm_;
     Pile merged_pile_;
+    // Cache of the nfps if none is shared through the configuration
+    std::shared_ptr<NfpCache<RawShape>> nfp_cache_ =
+            std::make_shared<NfpCache<RawShape>>();
 
 public:
 
@@ -612,14 +705,34 @@ private:
         }
         // /////////////////////////////////////////////////////////////////////
 
+        NfpCache<RawShape>& cache =
+                config_.nfp_cache ? *config_.nfp_cache : *nfp_cache_;
+
         __parallel::enumerate(items_.begin(), items_.end(),
-                              [&nfps, &trsh](const Item& sh, size_t n)
+                              [&nfps, &trsh, &cache](const Item& sh, size_t n)
         {
             auto& fixedp = sh.transformedShape();
             auto& orbp = trsh.transformedShape();
-            auto subnfp_r = noFitPolygon<NfpLevel::CONVEX_ONLY>(fixedp, orbp);
-            correctNfpPosition(subnfp_r, sh, trsh);
-            nfps[n] = subnfp_r.first;
+
+            if(sl::contourVertexCount(fixedp) == 0 ||
+               sl::contourVertexCount(orbp) == 0) {
+                auto subnfp_r = noFitPolygon<NfpLevel::CONVEX_ONLY>(fixedp, orbp);
+                correctNfpPosition(subnfp_r, sh, trsh);
+                nfps[n] = subnfp_r.first;
+                return;
+            }
+
+            auto key = NfpCache<RawShape>::key(fixedp, orbp);
+            Vertex ref = *sl::cbegin(fixedp);
+            if(cache.find(key, nfps[n])) {
+                sl::translate(nfps[n], ref);
+            } else {
+                auto subnfp_r = noFitPolygon<NfpLevel::CONVEX_ONLY>(fixedp, orbp);
+                correctNfpPosition(subnfp_r, sh, trsh);
+                nfps[n] = subnfp_r.first;
+                sl::translate(subnfp_r.first, Vertex{0, 0} - ref);
+                cache.insert(std::move(key), std::move(subnfp_r.first));
+            }
         });
 
         return nfp::merge(nfps);
@@ -819,111 +932,91 @@ private:
                 using OptResult = opt::Result<double>;
                 using OptResults = std::vector<OptResult>;
 
-                // Local optimization with the four polygon corners as
-                // starting points
+                // Local optimization with the corners of the nfps and of
+                // their holes as starting points. All the starting points
+                // are optimized in a single parallel loop, as a crowded bin
+                // produces many small nfps with just a few corners each.
+                struct StartPoint {
+                    double pos;
+                    unsigned nfpidx;
+                    int hidx;
+                };
+
+                std::vector<StartPoint> starts;
+                // Ranges of starting points of a single nfp contour or hole
+                std::vector<size_t> groups;
                 for(unsigned ch = 0; ch < ecache.size(); ch++) {
                     auto& cache = ecache[ch];
+                    groups.emplace_back(starts.size());
+                    for(double pos : cache.corners())
+                        starts.push_back({pos, ch, -1});
+                    for(unsigned hidx = 0; hidx < cache.holeCount(); ++hidx) {
+                        groups.emplace_back(starts.size());
+                        for(double pos : cache.corners(hidx))
+                            starts.push_back({pos, ch, int(hidx)});
+                    }
+                }
+                groups.emplace_back(starts.size());
 
-                    OptResults results(cache.corners().size());
+                OptResults results(starts.size());
 
-                    auto& rofn = rawobjfunc;
-                    auto& nfpoint = getNfpPoint;
-                    float accuracy = config_.accuracy;
+                auto& rofn = rawobjfunc;
+                auto& nfpoint = getNfpPoint;
+                float accuracy = config_.accuracy;
 
-                    __parallel::enumerate(
-                                cache.corners().begin(),
-                                cache.corners().end(),
-                                [&results, &item, &rofn, &nfpoint, ch, accuracy]
-                                (double pos, size_t n)
-                    {
-                        Optimizer solver(accuracy);
-
-                        Item itemcpy = item;
-                        auto contour_ofn = [&rofn, &nfpoint, ch, &itemcpy]
-                                (double relpos)
-                        {
-                            Optimum op(relpos, ch);
-                            return rofn(nfpoint(op), itemcpy);
-                        };
-
-                        try {
-                            results[n] = solver.optimize_min(contour_ofn,
-                                            opt::initvals<double>(pos),
-                                            opt::bound<double>(0, 1.0)
-                                            );
-                        } catch(std::exception& e) {
-                            derr() << "ERROR: " << e.what() << "\n";
-                        }
-                    }, policy);
+                __parallel::enumerate(
+                            starts.begin(),
+                            starts.end(),
+                            [&results, &item, &rofn, &nfpoint, accuracy]
+                            (const StartPoint& start, size_t n)
+                {
+                    Optimizer solver(accuracy);
 
-                    auto resultcomp =
-                            []( const OptResult& r1, const OptResult& r2 ) {
-                        return r1.score < r2.score;
+                    Item itemcpy = item;
+                    auto contour_ofn = [&rofn, &nfpoint, &start, &itemcpy]
+                            (double relpos)
+                    {
+                        Optimum op(relpos, start.nfpidx, start.hidx);
+                        return rofn(nfpoint(op), itemcpy);
                     };
 
-                    auto mr = *std::min_element(results.begin(), results.end(),
-                                                resultcomp);
+                    try {
+                        results[n] = solver.optimize_min(contour_ofn,
+                                        opt::initvals<double>(start.pos),
+                                        opt::bound<double>(0, 1.0)
+                                        );
+                    } catch(std::exception& e) {
+                        derr() << "ERROR: " << e.what() << "\n";
+                    }
+                }, policy);
+
+                auto resultcomp =
+                        []( const OptResult& r1, const OptResult& r2 ) {
+                    return r1.score < r2.score;
+                };
+
+                // Reduce the results in the order of the nfps and their holes,
+                // taking the first of the equal scores, so that the result
+                // does not depend on the scheduling of the parallel loop.
+                for(size_t g = 0; g + 1 < groups.size(); ++g) {
+                    if(groups[g] == groups[g + 1]) continue;
 
-                    if(mr.score < best_score) {
-                        Optimum o(std::get<0>(mr.optimum), ch, -1);
+                    auto mr = std::min_element(results.begin() + groups[g],
+                                               results.begin() + groups[g + 1],
+                                               resultcomp);
+
+                    if(mr->score < best_score) {
+                        const StartPoint& start = starts[groups[g]];
+                        Optimum o(std::get<0>(mr->optimum),
+                                  start.nfpidx, start.hidx);
                         double miss = boundaryCheck(o);
                         if(miss <= 0) {
-                            best_score = mr.score;
+                            best_score = mr->score;
                             optimum = o;
                         } else {
                             best_overfit = std::min(miss, best_overfit);
                         }
                     }
-
-                    for(unsigned hidx = 0; hidx < cache.holeCount(); ++hidx) {
-                        results.clear();
-                        results.resize(cache.corners(hidx).size());
-
-                        // TODO : use parallel for
-                        __parallel::enumerate(cache.corners(hidx).begin(),
-                                      cache.corners(hidx).end(),
-                                      [&results, &item, &nfpoint,
-                                       &rofn, ch, hidx, accuracy]
-                                      (double pos, size_t n)
-                        {
-                            Optimizer solver(accuracy);
-
-                            Item itmcpy = item;
-                            auto hole_ofn =
-                                    [&rofn, &nfpoint, ch, hidx, &itmcpy]
-                                    (double pos)
-                            {
-                                Optimum opt(pos, ch, hidx);
-                                return rofn(nfpoint(opt), itmcpy);
-                            };
-
-                            try {
-                                results[n] = solver.optimize_min(hole_ofn,
-                                                opt::initvals<double>(pos),
-                                                opt::bound<double>(0, 1.0)
-                                                );
-
-                            } catch(std::exception& e) {
-                                derr() << "ERROR: " << e.what() << "\n";
-                            }
-                        }, policy);
-
-                        auto hmr = *std::min_element(results.begin(),
-                                                    results.end(),
-                                                    resultcomp);
-
-                        if(hmr.score < best_score) {
-                            Optimum o(std::get<0>(hmr.optimum),
-                                      ch, hidx);
-                            double miss = boundaryCheck(o);
-                            if(miss <= 0.0) {
-                                best_score = hmr.score;
-                                optimum = o;
-                            } else {
-                                best_overfit = std::min(miss, best_overfit);
-                            }
-                        }
-                    }
                 }
 
                 if( best_score < global_score ) {
@@ -7,8 +7,11 @@
 #define slic3r_AABBTreeIndirect_hpp_
 
 #include <algorithm>
+#include <cstdint>
+#include <cstring>
 #include <limits>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "Utils.hpp" // for next_highest_power_of_2()
@@ -399,6 +402,151 @@ namespace detail {
 		}
 	}
 
+	// Packet of rays traversing the AABB tree together, stored as structure of arrays,
+	// so that the ray / box test of a single node over all rays of the packet is vectorized by the compiler.
+	template<size_t ANumRays, typename AScalar>
+	struct RayPacket {
+		static constexpr size_t NumRays = ANumRays;
+		using Scalar = AScalar;
+		using Mask   = uint32_t;
+		// Unsigned integer of the size of Scalar, for bitwise selects.
+		using Bits   = std::conditional_t<sizeof(Scalar) == 8, uint64_t, uint32_t>;
+		static_assert(NumRays <= sizeof(Mask) * 8, "Ray packet too large for its mask");
+		static_assert(sizeof(Bits) == sizeof(Scalar), "Unsupported scalar type");
+
+		Scalar origin[3][NumRays];
+		Scalar invdir[3][NumRays];
+		// Parameter of the closest hit found so far.
+		Scalar t_max[NumRays];
+		// All ones for a negative invdir, zero otherwise.
+		Bits   neg[3][NumRays];
+		// Bit mask of the rays with a valid origin and direction.
+		Mask   valid = 0;
+
+		// All ones if true, zero otherwise.
+		static Bits to_bits(bool b) { return Bits(0) - Bits(b); }
+		static Scalar select(Bits mask, Scalar a, Scalar b) {
+			Bits ba, bb;
+			memcpy(&ba, &a, sizeof(Scalar));
+			memcpy(&bb, &b, sizeof(Scalar));
+			ba = (ba & mask) | (bb & ~mask);
+			memcpy(&a, &ba, sizeof(Scalar));
+			return a;
+		}
+
+		// Test the box against the rays of the packet enabled by mask, returns a mask of the rays intersecting the box
+		// within (0, t_max). The same arithmetic as ray_box_intersect_invdir(), thus with exactly the same outcome.
+		template<typename BoxType>
+		Mask intersect_box(const BoxType &box, Mask mask) const {
+#ifdef __AVX__
+			// Without the early exits and branches of ray_box_intersect_invdir(): Branching on the signs
+			// of the directions of the rays would be unpredictable, while the bitwise selects let the compiler
+			// vectorize the loop over all rays of the packet.
+			Scalar lo[3], hi[3];
+			for (int d = 0; d < 3; ++ d) {
+				lo[d] = Scalar(box.min()(d));
+				hi[d] = Scalar(box.max()(d));
+			}
+			Bits ok[NumRays];
+			for (size_t i = 0; i < NumRays; ++ i) {
+				Scalar tnear[3], tfar[3];
+				for (int d = 0; d < 3; ++ d) {
+					Scalar tlo = (lo[d] - origin[d][i]) * invdir[d][i];
+					Scalar thi = (hi[d] - origin[d][i]) * invdir[d][i];
+					tnear[d] = select(neg[d][i], thi, tlo);
+					tfar [d] = select(neg[d][i], tlo, thi);
+				}
+				Scalar tmin = select(to_bits(tnear[1] > tnear[0]), tnear[1], tnear[0]);
+				Scalar tmax = select(to_bits(tfar[1] < tfar[0]), tfar[1], tfar[0]);
+				Bits   m    = ~ to_bits(tnear[0] > tfar[1]) & ~ to_bits(tnear[1] > tfar[0]) &
+							  ~ to_bits(tnear[2] > tmax) & ~ to_bits(tmin > tfar[2]);
+				tmin = select(to_bits(tnear[2] > tmin), tnear[2], tmin);
+				tmax = select(to_bits(tfar[2] < tmax), tfar[2], tmax);
+				ok[i] = m & to_bits(tmin < t_max[i]) & to_bits(tmax > Scalar(0));
+			}
+			Mask out = 0;
+			for (size_t i = 0; i < NumRays; ++ i)
+				out |= Mask(ok[i] & 1) << i;
+			return out & mask;
+#else
+			// Two doubles per SSE2 or NEON instruction do not pay for testing the inactive rays, test the active ones one by one.
+			using Vector = Eigen::Matrix<Scalar, 3, 1, Eigen::DontAlign>;
+			const Eigen::AlignedBox<Scalar, 3> bbox = box.template cast<Scalar>();
+			for (Mask m = mask; m != 0; m &= m - 1) {
+				size_t i = 0;
+				while (! (m & (Mask(1) << i)))
+					++ i;
+				if (! ray_box_intersect_invdir(
+						Vector(origin[0][i], origin[1][i], origin[2][i]), Vector(invdir[0][i], invdir[1][i], invdir[2][i]),
+						bbox, Scalar(0), t_max[i]))
+					mask &= ~ (Mask(1) << i);
+			}
+			return mask;
+#endif
+		}
+	};
+
+	// Traverse the tree with a packet of rays depth first, visiting the nodes in the same order as
+	// intersect_ray_recursive_first_hit() does, thus finding the same first hits.
+	// A node is only entered by the rays, which intersected all of its parents.
+	template<typename RayPacketType, typename VertexType, typename IndexedFaceType, typename TreeType, typename VectorType>
+	static inline void intersect_ray_packet_first_hit(
+		const std::vector<VertexType> 		&vertices,
+		const std::vector<IndexedFaceType> 	&faces,
+		const TreeType 						&tree,
+		RayPacketType 						&packet,
+		const VectorType 					*origins,
+		const VectorType 					*dirs,
+		igl::Hit 							*hits)
+	{
+		using Mask = typename RayPacketType::Mask;
+		// The tree is balanced, thus its depth is bounded by the bit size of its node index.
+		std::pair<size_t, Mask> stack[sizeof(size_t) * 8 * 2];
+		size_t 					stack_size = 0;
+		stack[stack_size ++] = { size_t(0), packet.valid };
+		while (stack_size > 0) {
+			auto [node_idx, mask] = stack[-- stack_size];
+			const auto &node = tree.node(node_idx);
+			assert(node.is_valid());
+			mask = packet.intersect_box(node.bbox, mask);
+			if (mask == 0)
+				continue;
+			if ((mask & (mask - 1)) == 0 && node.is_inner()) {
+				// A single ray left in this subtree, testing the whole packet would be wasteful.
+				size_t i = 0;
+				while (! (mask & (Mask(1) << i)))
+					++ i;
+				auto ray_intersector = RayIntersector<VertexType, IndexedFaceType, TreeType, VectorType> {
+					vertices, faces, tree,
+					origins[i], dirs[i], VectorType(dirs[i].cwiseInverse())
+				};
+				igl::Hit hit;
+				if (intersect_ray_recursive_first_hit(ray_intersector, node_idx, packet.t_max[i], hit) && hit.t < packet.t_max[i]) {
+					hits[i] 		= hit;
+					packet.t_max[i] = hit.t;
+				}
+				continue;
+			}
+			if (node.is_leaf()) {
+				auto face = faces[node.idx];
+				for (size_t i = 0; i < RayPacketType::NumRays; ++ i)
+					if (mask & (Mask(1) << i)) {
+						double t, u, v;
+						// Compare the hits rounded to float as intersect_ray_recursive_first_hit() does.
+						if (intersect_triangle(origins[i], dirs[i], vertices[face(0)], vertices[face(1)], vertices[face(2)], t, u, v)
+							&& t > 0. && typename RayPacketType::Scalar(float(t)) < packet.t_max[i]) {
+							hits[i] = igl::Hit { int(node.idx), -1, float(u), float(v), float(t) };
+							packet.t_max[i] = hits[i].t;
+						}
+					}
+			} else {
+				// Push the right child first to process the left one first.
+				stack[stack_size ++] = { TreeType::right_child_idx(node_idx), mask };
+				stack[stack_size ++] = { TreeType::left_child_idx(node_idx), mask };
+			}
+		}
+	}
+
 	// Nothing to do with COVID-19 social distancing.
 	template<typename AVertexType, typename AIndexedFaceType, typename ATreeType, typename AVectorType>
 	struct IndexedTriangleSetDistancer {
@@ -665,6 +813,60 @@ inline bool intersect_ray_all_hits(
 	return ! hits.empty();
 }
 
+// Number of rays traversing the tree together in intersect_rays_first_hit().
+static constexpr size_t RayPacketSize = 8;
+
+// Find the first intersections of a bunch of rays with indexed triangle set.
+// The rays are traversed through the tree in packets of RayPacketSize, thus the nodes are fetched
+// once for all the rays of a packet, which pays off for coherent rays (sharing a source or a direction).
+// The hits are the same as returned by intersect_ray_first_hit() for each of the rays,
+// a ray with no hit gets a hit with an infinite parameter t and a negative id.
+template<typename VertexType, typename IndexedFaceType, typename TreeType, typename VectorType>
+inline void intersect_rays_first_hit(
+	// Indexed triangle set - 3D vertices.
+	const std::vector<VertexType> 		&vertices,
+	// Indexed triangle set - triangular faces, references to vertices.
+	const std::vector<IndexedFaceType> 	&faces,
+	// AABBTreeIndirect::Tree over vertices & faces, bounding boxes built with the accuracy of vertices.
+	const TreeType 						&tree,
+	// Origins of the rays.
+	const VectorType					*origins,
+	// Directions of the rays.
+	const VectorType 					*dirs,
+	// Number of the rays.
+	size_t 								num_rays,
+	// First intersections of the rays with the indexed triangle set, num_rays of them.
+	igl::Hit 							*hits)
+{
+	using Scalar 	 = typename VectorType::Scalar;
+	using RayPacket  = detail::RayPacket<RayPacketSize, Scalar>;
+
+	for (size_t i = 0; i < num_rays; ++ i)
+		hits[i] = igl::Hit { -1, -1, 0.f, 0.f, std::numeric_limits<float>::infinity() };
+	if (tree.empty())
+		return;
+
+	for (size_t begin = 0; begin < num_rays; begin += RayPacket::NumRays) {
+		size_t 	  n = std::min(RayPacket::NumRays, num_rays - begin);
+		RayPacket packet;
+		packet.valid = 0;
+		for (size_t i = 0; i < RayPacket::NumRays; ++ i) {
+			// The unused lanes replicate the first ray, they are masked out.
+			size_t 	   k 	  = begin + (i < n ? i : 0);
+			VectorType invdir = dirs[k].cwiseInverse();
+			for (int d = 0; d < 3; ++ d) {
+				packet.origin[d][i] = origins[k](d);
+				packet.invdir[d][i] = invdir(d);
+				packet.neg[d][i] 	= RayPacket::to_bits(invdir(d) < 0);
+			}
+			packet.t_max[i] = std::numeric_limits<Scalar>::infinity();
+			if (i < n)
+				packet.valid |= typename RayPacket::Mask(1) << i;
+		}
+		detail::intersect_ray_packet_first_hit(vertices, faces, tree, packet, origins + begin, dirs + begin, hits + begin);
+	}
+}
+
 // Finding a closest triangle, its closest point and squared distance to the closest point
 // on a 3D indexed triangle set using a pre-built AABBTreeIndirect::Tree.
 // Closest point to triangle test will be performed with the accuracy of VectorType::Scalar
@@ -105,6 +105,10 @@ void fill_config(PConf& pcfg, const ArrangeParams &params) {
     
     // Allow parallel execution.
     pcfg.parallel = params.parallel;
+
+    // Reuse the no-fit polygons over all the bins of this arrangement, the plates are usually made of many copies
+    // of a few parts. The cache is released together with the arrangement.
+    pcfg.nfp_cache = std::make_shared<typename decltype(pcfg.nfp_cache)::element_type>();
 }
 
 // Apply penalty to object function result. This is used only when alignment
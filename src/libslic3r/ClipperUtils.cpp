@@ -1,7 +1,10 @@
 #include "ClipperUtils.hpp"
+#include "BoundingBox.hpp"
 #include "Geometry.hpp"
 #include "ShortestPath.hpp"
 
+#include <tbb/parallel_for.h>
+
 // #define CLIPPER_UTILS_DEBUG
 
 #ifdef CLIPPER_UTILS_DEBUG
@@ -125,19 +128,34 @@ ExPolygons PolyTreeToExPolygons(ClipperLib::PolyTree& polytree)
 }
 //-----------------------------------------------------------
 
+// ClipperLib::IntPoint (compiled without the Z coordinate) and Slic3r::Point both consist of two 64bit integers,
+// therefore the points are converted between the two libraries by a block copy, not point by point.
+static constexpr bool clipper_point_same_layout = sizeof(ClipperLib::IntPoint) == sizeof(Point) && std::is_same<ClipperLib::cInt, coord_t>::value;
+
+static inline void ClipperPath_to_Slic3rPoints(const ClipperLib::Path &input, Points &out)
+{
+    if constexpr (clipper_point_same_layout) {
+        out.resize(input.size());
+        if (! input.empty())
+            memcpy(reinterpret_cast<void*>(out.data()), input.data(), input.size() * sizeof(Point));
+    } else {
+        out.reserve(input.size());
+        for (const ClipperLib::IntPoint &pt : input)
+            out.emplace_back(pt.X, pt.Y);
+    }
+}
+
 Slic3r::Polygon ClipperPath_to_Slic3rPolygon(const ClipperLib::Path &input)
 {
     Polygon retval;
-    for (ClipperLib::Path::const_iterator pit = input.begin(); pit != input.end(); ++pit)
-        retval.points.emplace_back(pit->X, pit->Y);
+    ClipperPath_to_Slic3rPoints(input, retval.points);
     return retval;
 }
 
 Slic3r::Polyline ClipperPath_to_Slic3rPolyline(const ClipperLib::Path &input)
 {
     Polyline retval;
-    for (ClipperLib::Path::const_iterator pit = input.begin(); pit != input.end(); ++pit)
-        retval.points.emplace_back(pit->X, pit->Y);
+    ClipperPath_to_Slic3rPoints(input, retval.points);
     return retval;
 }
 
@@ -177,8 +195,15 @@ ExPolygons ClipperPaths_to_Slic3rExPolygons(const ClipperLib::Paths &input)
 ClipperLib::Path Slic3rMultiPoint_to_ClipperPath(const MultiPoint &input)
 {
     ClipperLib::Path retval;
-    for (Points::const_iterator pit = input.points.begin(); pit != input.points.end(); ++pit)
-        retval.emplace_back((*pit)(0), (*pit)(1));
+    if constexpr (clipper_point_same_layout) {
+        retval.resize(input.points.size());
+        if (! input.points.empty())
+            memcpy(reinterpret_cast<void*>(retval.data()), input.points.data(), input.points.size() * sizeof(Point));
+    } else {
+        retval.reserve(input.points.size());
+        for (const Point &pt : input.points)
+            retval.emplace_back(pt.x(), pt.y());
+    }
     return retval;
 }
 
@@ -194,6 +219,7 @@ ClipperLib::Path Slic3rMultiPoint_to_ClipperPath_reversed(const Slic3r::MultiPoi
 ClipperLib::Paths Slic3rMultiPoints_to_ClipperPaths(const Polygons &input)
 {
     ClipperLib::Paths retval;
+    retval.reserve(input.size());
     for (Polygons::const_iterator it = input.begin(); it != input.end(); ++it)
         retval.emplace_back(Slic3rMultiPoint_to_ClipperPath(*it));
     return retval;
@@ -202,6 +228,7 @@ ClipperLib::Paths Slic3rMultiPoints_to_ClipperPaths(const Polygons &input)
 ClipperLib::Paths  Slic3rMultiPoints_to_ClipperPaths(const ExPolygons &input)
 {
     ClipperLib::Paths retval;
+    retval.reserve(number_polygons(input));
     for (auto &ep : input) {
         retval.emplace_back(Slic3rMultiPoint_to_ClipperPath(ep.contour));
         
@@ -215,6 +242,7 @@ ClipperLib::Paths  Slic3rMultiPoints_to_ClipperPaths(const ExPolygons &input)
 ClipperLib::Paths Slic3rMultiPoints_to_ClipperPaths(const Polylines &input)
 {
     ClipperLib::Paths retval;
+    retval.reserve(input.size());
     for (Polylines::const_iterator it = input.begin(); it != input.end(); ++it)
         retval.emplace_back(Slic3rMultiPoint_to_ClipperPath(*it));
     return retval;
@@ -309,95 +337,118 @@ ClipperLib::Paths _offset(const Slic3r::ExPolygon &expolygon, const double delta
     return output;
 }
 
+// Offset a single ExPolygon of _offset(const ExPolygons&) into out, which is expected to be empty.
+// The ClipperOffset is passed in to be reused over the contours and holes of all the ExPolygons processed by a thread.
+// Returns false if the offsetted ExPolygon vanished.
+static bool _offset_expolygon(const Slic3r::ExPolygon &expolygon, const double delta, ClipperLib::JoinType joinType, double miterLimit,
+    ClipperLib::ClipperOffset &co, ClipperLib::Paths &out)
+{
+    const double delta_scaled = delta * float(CLIPPER_OFFSET_SCALE);
+    // The offset parameters stay the same for all the contours and holes, only the paths are cleared.
+    if (joinType == jtRound)
+        co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
+    else
+        co.MiterLimit = miterLimit;
+    co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
+
+    // 1) Offset the outer contour.
+    ClipperLib::Paths contours;
+    {
+        ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath(expolygon.contour);
+        scaleClipperPolygon(input);
+        co.Clear();
+        co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
+        co.Execute(contours, delta_scaled);
+    }
+    if (contours.empty())
+        // No need to try to offset the holes.
+        return false;
+
+    if (expolygon.holes.empty()) {
+        // No need to subtract holes from the offsetted expolygon, we are done.
+        out = std::move(contours);
+        return true;
+    }
+
+    // 2) Offset the holes one by one, collect the offsetted holes.
+    ClipperLib::Paths holes;
+    for (Polygons::const_iterator it_hole = expolygon.holes.begin(); it_hole != expolygon.holes.end(); ++ it_hole) {
+        ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath_reversed(*it_hole);
+        scaleClipperPolygon(input);
+        co.Clear();
+        co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
+        ClipperLib::Paths out_hole;
+        co.Execute(out_hole, - delta_scaled);
+        holes.insert(holes.end(), std::make_move_iterator(out_hole.begin()), std::make_move_iterator(out_hole.end()));
+    }
+
+    // 3) Subtract holes from the contours.
+    if (holes.empty()) {
+        // No hole remaining after an offset. Just copy the outer contour.
+        out = std::move(contours);
+    } else if (delta < 0) {
+        // Negative offset. There is a chance, that the offsetted hole intersects the outer contour. 
+        // Subtract the offsetted holes from the offsetted contours.
+        ClipperLib::Clipper clipper;
+        clipper.Clear();
+        clipper.AddPaths(contours, ClipperLib::ptSubject, true);
+        clipper.AddPaths(holes, ClipperLib::ptClip, true);
+        clipper.Execute(ClipperLib::ctDifference, out, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
+        // The offsetted holes may have eaten up the offsetted outer contour.
+        return ! out.empty();
+    } else {
+        // Positive offset. As long as the Clipper offset does what one expects it to do, the offsetted hole will have a smaller
+        // area than the original hole or even disappear, therefore there will be no new intersections.
+        // Just collect the reversed holes.
+        out = std::move(contours);
+        out.reserve(out.size() + holes.size());
+        // Reverse the holes in place.
+        for (size_t i = 0; i < holes.size(); ++ i)
+            std::reverse(holes[i].begin(), holes[i].end());
+        out.insert(out.end(), std::make_move_iterator(holes.begin()), std::make_move_iterator(holes.end()));
+    }
+    return true;
+}
+
+// Layers made of many small islands (text, lattices) are offsetted island by island in parallel above this count.
+static constexpr size_t OFFSET_EXPOLYGONS_PARALLEL_MIN = 64;
+
 // This is a safe variant of the polygons offset, tailored for multiple ExPolygons.
 // It is required, that the input expolygons do not overlap and that the holes of each ExPolygon don't intersect with their respective outer contours.
 // Each ExPolygon is offsetted separately, then the offsetted ExPolygons are united.
 ClipperLib::Paths _offset(const Slic3r::ExPolygons &expolygons, const double delta,
     ClipperLib::JoinType joinType, double miterLimit)
 {
-    const double delta_scaled = delta * float(CLIPPER_OFFSET_SCALE);
     // Offsetted ExPolygons before they are united.
     ClipperLib::Paths contours_cummulative;
     contours_cummulative.reserve(expolygons.size());
     // How many non-empty offsetted expolygons were actually collected into contours_cummulative?
     // If only one, then there is no need to do a final union.
     size_t expolygons_collected = 0;
-    for (Slic3r::ExPolygons::const_iterator it_expoly = expolygons.begin(); it_expoly != expolygons.end(); ++ it_expoly) {
-        // 1) Offset the outer contour.
-        ClipperLib::Paths contours;
-        {
-            ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath(it_expoly->contour);
-            scaleClipperPolygon(input);
-            ClipperLib::ClipperOffset co;
-            if (joinType == jtRound)
-                co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
-            else
-                co.MiterLimit = miterLimit;
-            co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-            co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
-            co.Execute(contours, delta_scaled);
-        }
-        if (contours.empty())
-            // No need to try to offset the holes.
-            continue;
-
-        if (it_expoly->holes.empty()) {
-            // No need to subtract holes from the offsetted expolygon, we are done.
-            contours_cummulative.insert(contours_cummulative.end(), contours.begin(), contours.end());
-            ++ expolygons_collected;
-        } else {
-            // 2) Offset the holes one by one, collect the offsetted holes.
-            ClipperLib::Paths holes;
-            {
-                for (Polygons::const_iterator it_hole = it_expoly->holes.begin(); it_hole != it_expoly->holes.end(); ++ it_hole) {
-                    ClipperLib::Path input = Slic3rMultiPoint_to_ClipperPath_reversed(*it_hole);
-                    scaleClipperPolygon(input);
-                    ClipperLib::ClipperOffset co;
-                    if (joinType == jtRound)
-                        co.ArcTolerance = miterLimit * double(CLIPPER_OFFSET_SCALE);
-                    else
-                        co.MiterLimit = miterLimit;
-                    co.ShortestEdgeLength = double(std::abs(delta_scaled * CLIPPER_OFFSET_SHORTEST_EDGE_FACTOR));
-                    co.AddPath(input, joinType, ClipperLib::etClosedPolygon);
-                    ClipperLib::Paths out;
-                    co.Execute(out, - delta_scaled);
-                    holes.insert(holes.end(), out.begin(), out.end());
-                }
-            }
-
-            // 3) Subtract holes from the contours.
-            if (holes.empty()) {
-                // No hole remaining after an offset. Just copy the outer contour.
-                contours_cummulative.insert(contours_cummulative.end(), contours.begin(), contours.end());
-                ++ expolygons_collected;
-            } else if (delta < 0) {
-                // Negative offset. There is a chance, that the offsetted hole intersects the outer contour. 
-                // Subtract the offsetted holes from the offsetted contours.
-                ClipperLib::Clipper clipper;
-                clipper.Clear();
-                clipper.AddPaths(contours, ClipperLib::ptSubject, true);
-                clipper.AddPaths(holes, ClipperLib::ptClip, true);
-                ClipperLib::Paths output;
-                clipper.Execute(ClipperLib::ctDifference, output, ClipperLib::pftNonZero, ClipperLib::pftNonZero);
-                if (! output.empty()) {
-                    contours_cummulative.insert(contours_cummulative.end(), output.begin(), output.end());
-                    ++ expolygons_collected;
-                } else {
-                    // The offsetted holes have eaten up the offsetted outer contour.
-                }
-            } else {
-                // Positive offset. As long as the Clipper offset does what one expects it to do, the offsetted hole will have a smaller
-                // area than the original hole or even disappear, therefore there will be no new intersections.
-                // Just collect the reversed holes.
-                contours_cummulative.reserve(contours.size() + holes.size());
-                contours_cummulative.insert(contours_cummulative.end(), contours.begin(), contours.end());
-                // Reverse the holes in place.
-                for (size_t i = 0; i < holes.size(); ++ i)
-                    std::reverse(holes[i].begin(), holes[i].end());
-                contours_cummulative.insert(contours_cummulative.end(), holes.begin(), holes.end());
+    if (expolygons.size() < OFFSET_EXPOLYGONS_PARALLEL_MIN) {
+        ClipperLib::ClipperOffset co;
+        for (const ExPolygon &expoly : expolygons) {
+            ClipperLib::Paths out;
+            if (_offset_expolygon(expoly, delta, joinType, miterLimit, co, out)) {
+                contours_cummulative.insert(contours_cummulative.end(), std::make_move_iterator(out.begin()), std::make_move_iterator(out.end()));
                 ++ expolygons_collected;
             }
         }
+    } else {
+        // The islands are independent, collect them in their original order to produce the same output as the loop above.
+        std::vector<ClipperLib::Paths> out(expolygons.size());
+        std::vector<unsigned char>      collected(expolygons.size(), false);
+        tbb::parallel_for(tbb::blocked_range<size_t>(0, expolygons.size()),
+            [&expolygons, delta, joinType, miterLimit, &out, &collected](const tbb::blocked_range<size_t> &range) {
+                ClipperLib::ClipperOffset co;
+                for (size_t i = range.begin(); i < range.end(); ++ i)
+                    collected[i] = _offset_expolygon(expolygons[i], delta, joinType, miterLimit, co, out[i]);
+            });
+        for (size_t i = 0; i < expolygons.size(); ++ i)
+            if (collected[i]) {
+                contours_cummulative.insert(contours_cummulative.end(), std::make_move_iterator(out[i].begin()), std::make_move_iterator(out[i].end()));
+                ++ expolygons_collected;
+            }
     }
 
     // 4) Unite the offsetted expolygons.
@@ -747,6 +798,76 @@ _clipper_ln(ClipperLib::ClipType clipType, const Lines &subject, const Polygons
     return retval;
 }
 
+// Bounding box of a clip polygon, grown to cover the safety offset applied to the clip polygons by _clipper_do().
+static inline BoundingBox clip_extents(const Polygon &clip, bool safety_offset_)
+{
+    BoundingBox bbox = get_extents(clip);
+    if (safety_offset_)
+        bbox.offset(SCALED_EPSILON);
+    return bbox;
+}
+
+static Polygons clip_polygons_overlapping(const BoundingBox &bbox_subject, const Polygons &clip, bool safety_offset_)
+{
+    Polygons out;
+    for (const Polygon &polygon : clip)
+        if (bbox_subject.overlap(clip_extents(polygon, safety_offset_)))
+            out.emplace_back(polygon);
+    return out;
+}
+
+ExPolygons diff_ex_clipped(const Polygons &subject, const Polygons &clip, bool safety_offset_)
+{
+    if (subject.empty())
+        return ExPolygons();
+    return _clipper_ex(ClipperLib::ctDifference, subject, clip_polygons_overlapping(get_extents(subject), clip, safety_offset_), safety_offset_);
+}
+
+ExPolygons intersection_ex_clipped(const Polygons &subject, const Polygons &clip, bool safety_offset_)
+{
+    if (subject.empty())
+        return ExPolygons();
+    Polygons clip_overlapping = clip_polygons_overlapping(get_extents(subject), clip, safety_offset_);
+    return clip_overlapping.empty() ? ExPolygons() : _clipper_ex(ClipperLib::ctIntersection, subject, clip_overlapping, safety_offset_);
+}
+
+// Only the clip islands touching some subject island are passed to Clipper. All the subject islands are passed to Clipper,
+// so that they are cleaned up by the safety offset and united the same way as by diff_ex() / intersection_ex().
+static ExPolygons _clipper_ex_clipped(ClipperLib::ClipType clipType, const ExPolygons &subject, const ExPolygons &clip, bool safety_offset_)
+{
+    assert(clipType == ClipperLib::ctDifference || clipType == ClipperLib::ctIntersection);
+    if (subject.empty())
+        return ExPolygons();
+
+    std::vector<BoundingBox> bboxes_subject;
+    bboxes_subject.reserve(subject.size());
+    for (const ExPolygon &expoly : subject)
+        bboxes_subject.emplace_back(get_extents(expoly.contour));
+
+    Polygons clip_polygons;
+    for (const ExPolygon &expoly : clip) {
+        BoundingBox bbox = clip_extents(expoly.contour, safety_offset_);
+        for (const BoundingBox &bbox_subject : bboxes_subject)
+            if (bbox_subject.overlap(bbox)) {
+                polygons_append(clip_polygons, expoly);
+                break;
+            }
+    }
+
+    return clip_polygons.empty() && clipType == ClipperLib::ctIntersection ? ExPolygons() :
+        _clipper_ex(clipType, to_polygons(subject), clip_polygons, safety_offset_);
+}
+
+ExPolygons diff_ex_clipped(const ExPolygons &subject, const ExPolygons &clip, bool safety_offset_)
+{
+    return _clipper_ex_clipped(ClipperLib::ctDifference, subject, clip, safety_offset_);
+}
+
+ExPolygons intersection_ex_clipped(const ExPolygons &subject, const ExPolygons &clip, bool safety_offset_)
+{
+    return _clipper_ex_clipped(ClipperLib::ctIntersection, subject, clip, safety_offset_);
+}
+
 ClipperLib::PolyTree union_pt(const Polygons &subject, bool safety_offset_)
 {
     return _clipper_do<ClipperLib::PolyTree>(ClipperLib::ctUnion, subject, Polygons(), ClipperLib::pftEvenOdd, safety_offset_);
@@ -158,6 +158,15 @@ intersection_ex(const Slic3r::ExPolygons &subject, const Slic3r::ExPolygons &cli
     return _clipper_ex(ClipperLib::ctIntersection, to_polygons(subject), to_polygons(clip), safety_offset_);
 }
 
+// Variants of diff_ex() / intersection_ex() culling the clip polygons by their bounding boxes first,
+// to be used if the clip set is large and most of it does not touch the subject (many instances on a plate, sparse supports).
+// The ExPolygons variants cull the clip islands not touching any subject island. The subject is always processed by Clipper,
+// thus the result is the same as the one of diff_ex() / intersection_ex(), including the cleanup done by the safety offset.
+Slic3r::ExPolygons diff_ex_clipped(const Slic3r::Polygons &subject, const Slic3r::Polygons &clip, bool safety_offset_ = false);
+Slic3r::ExPolygons diff_ex_clipped(const Slic3r::ExPolygons &subject, const Slic3r::ExPolygons &clip, bool safety_offset_ = false);
+Slic3r::ExPolygons intersection_ex_clipped(const Slic3r::Polygons &subject, const Slic3r::Polygons &clip, bool safety_offset_ = false);
+Slic3r::ExPolygons intersection_ex_clipped(const Slic3r::ExPolygons &subject, const Slic3r::ExPolygons &clip, bool safety_offset_ = false);
+
 inline Slic3r::Polygons
 intersection(const Slic3r::ExPolygons &subject, const Slic3r::ExPolygons &clip, bool safety_offset_ = false)
 {
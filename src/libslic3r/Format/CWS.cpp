@@ -120,14 +120,7 @@ void MaskedCWSArchive::export_print(Zipper& zipper,
         zipper.add_entry("slicer.ini");
         zipper << to_ini(slicerconf);
         
-        size_t i = 0;
-        for (const sla::EncodedRaster &rst : m_layers) {
-
-            std::string imgname = project + string_printf("%.5d", i++) + "." +
-                                  rst.extension();
-            
-            zipper.add_entry(imgname.c_str(), rst.data(), rst.size());
-        }
+        export_layers(zipper, project);
     } catch(std::exception& e) {
         BOOST_LOG_TRIVIAL(error) << e.what();
         // Rethrow the exception
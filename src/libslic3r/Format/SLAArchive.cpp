@@ -1,4 +1,8 @@
 #include "Format/SLAArchive.hpp"
+
+#include "libslic3r/Utils.hpp"
+#include "libslic3r/SLA/Concurrency.hpp"
+
 namespace Slic3r {
 
 using ConfMap = std::map<std::string, std::string>;
@@ -48,7 +52,8 @@ uqptr<sla::RasterBase> SLAArchive::create_raster() const
 
     double gamma = this->config().gamma_correction.getFloat();
 
-    return sla::create_raster_grayscale_aa(res, pxdim, gamma, tr);
+    // Runs of pixels instead of a full grayscale buffer for each of the layers rendered in parallel.
+    return sla::create_raster_grayscale_aa_rle(res, pxdim, gamma, tr);
 }
 
 sla::RasterEncoder SLAArchive::get_encoder() const
@@ -56,4 +61,22 @@ sla::RasterEncoder SLAArchive::get_encoder() const
     return sla::PNGRasterEncoder{};
 }
 
+void SLAArchive::export_layers(Zipper &zipper, const std::string &project) const
+{
+    // Deflating thousands of high resolution layers dominates the export, thus the layers are compressed in parallel.
+    // The compressed layers are written in order before the next batch is compressed, so that the memory
+    // held by the compressed layers is capped.
+    std::vector<Zipper::CompressedEntry> batch;
+    for (size_t batch_begin = 0; batch_begin < m_layers.size(); batch_begin += m_max_layers_in_flight) {
+        batch.assign(std::min(m_max_layers_in_flight, m_layers.size() - batch_begin), Zipper::CompressedEntry());
+        sla::ccr::for_each(size_t(0), batch.size(), [this, &zipper, &project, &batch, batch_begin](size_t idx) {
+            const sla::EncodedRaster &rst     = m_layers[batch_begin + idx];
+            std::string               imgname = project + string_printf("%.5d", int(batch_begin + idx)) + "." + rst.extension();
+            batch[idx] = zipper.compress_entry(imgname, rst.data(), rst.size());
+        });
+        for (const Zipper::CompressedEntry &entry : batch)
+            zipper.add_entry(entry);
+    }
+}
+
 } // namespace Slic3r
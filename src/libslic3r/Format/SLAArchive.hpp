@@ -1,6 +1,7 @@
 #ifndef slic3r_FORMAT_SLACOMMON_HPP
 #define slic3r_FORMAT_SLACOMMON_HPP
 
+#include <algorithm>
 #include <string>
 
 #include "libslic3r/Zipper.hpp"
@@ -11,14 +12,29 @@ namespace Slic3r {
 /// Common abstract base class for SLA archive formats.
 /// Partial refactor from Slic3r::SL1Archive
 class SLAArchive: public SLAPrinter {
+    // Number of layers compressed at once by export_layers(), capping the memory held by the compressed layers
+    // waiting to be written into the archive.
+    size_t m_max_layers_in_flight;
+
 protected:
     virtual SLAPrinterConfig& config() = 0;
     virtual const SLAPrinterConfig& config() const = 0;
     
     uqptr<sla::RasterBase> create_raster() const override;
     sla::RasterEncoder get_encoder() const override;
+
+    /// Write the rasterized layers into the archive as <project>00000.<ext>, <project>00001.<ext>...
+    /// The layers are compressed in parallel in batches of max_layers_in_flight() and written in order.
+    void export_layers(Zipper &zipper, const std::string &project) const;
+
 public: 
-    SLAArchive() = default;
+    // Default number of layers compressed at once: a batch has to keep the worker threads of a desktop busy with
+    // layers of varying size, while the compressed layers of a 4K display stay in the order of tens of megabytes.
+    static constexpr size_t DefaultMaxLayersInFlight = 64;
+
+    explicit SLAArchive(size_t max_layers_in_flight = DefaultMaxLayersInFlight)
+        : m_max_layers_in_flight(std::max<size_t>(max_layers_in_flight, 1))
+    {}
    
     /// Actually perform the export. 
     virtual void export_print(Zipper &zipper, const SLAPrint &print, const std::string &projectname = "") = 0;
@@ -30,6 +46,9 @@ public:
         export_print(zipper, print, projectname);
     }
 
+    size_t max_layers_in_flight() const { return m_max_layers_in_flight; }
+    void   set_max_layers_in_flight(size_t n) { m_max_layers_in_flight = std::max<size_t>(n, 1); }
+
     void apply(const SLAPrinterConfig &cfg) override
     {
         auto diff = this->config().diff(cfg);
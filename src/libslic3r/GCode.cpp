@@ -34,6 +34,13 @@
 #include "SVG.hpp"
 
 #include <tbb/parallel_for.h>
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
 
 #include <Shiny/Shiny.h>
 
@@ -722,12 +729,17 @@ void GCode::do_export(Print* print, const char* path, GCodeProcessor::Result* re
     }
 
     BOOST_LOG_TRIVIAL(debug) << "Start processing gcode, " << log_memory_info();
+#if ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
+    // The G-code has already been fed to the processor by _write(), only the time estimates and the M73 lines are left.
+    m_processor.finalize(path_tmp, true, [print]() { print->throw_if_canceled(); });
+#else
     //klipper can hide gcode into a macro, so add guessed init gcode to the processor.
     if (this->config().start_gcode_manual) {
         std::string gcode = m_writer.preamble();
         m_processor.process_string(gcode, [print]() { print->throw_if_canceled(); });
     }
     m_processor.process_file(path_tmp, true, [print]() { print->throw_if_canceled(); });
+#endif // ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
     DoExport::update_print_estimated_times_stats(m_processor, print->m_print_statistics);
     if (result != nullptr)
         *result = std::move(m_processor.extract_result());
@@ -1183,6 +1195,14 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
     m_enable_extrusion_role_markers = false;
 #endif /* HAS_PRESSURE_EQUALIZER */
 
+#if ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
+    // The G-code is processed by m_processor while it is being written, see _write().
+    m_processor.initialize();
+    //klipper can hide gcode into a macro, so add guessed init gcode to the processor.
+    if (this->config().start_gcode_manual)
+        m_processor.process_string(m_writer.preamble());
+#endif // ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
+
     // Write information on the generator.
     _write_format(file, "; %s\n\n", Slic3r::header_slic3r_generated().c_str());
 
@@ -1422,10 +1442,13 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
 
     //flush FanMover buffer to avoid modifying the start gcode if it's manual.
     if (this->config().start_gcode_manual && this->m_fan_mover.get() != nullptr) {
-        std::string to_write = this->m_fan_mover.get()->process_gcode("", true);
+        std::string to_write = this->m_fan_mover.get()->process_gcode("", true, m_writer.tool() == nullptr ? 0 : m_writer.tool()->id());
         const char* gcode_to_write = to_write.c_str();
         // writes string to file
         fwrite(gcode_to_write, 1, ::strlen(gcode_to_write), file);
+#if ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
+        m_processor.process_buffer(to_write);
+#endif // ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
     }
 
     // Process filament-specific gcode.
@@ -1564,13 +1587,12 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
                 m_cooling_buffer->reset();
                 m_cooling_buffer->set_current_extruder(initial_extruder_id);
                 // Pair the object layers with the support layers by z, extrude them.
-                std::vector<LayerToPrint> layers_to_print = collect_layers_to_print(object);
-                for (LayerToPrint &ltp : layers_to_print) {
-                    std::vector<LayerToPrint> lrs;
-                    lrs.emplace_back(std::move(ltp));
-                    this->process_layer(file, print, print.m_print_statistics, lrs, tool_ordering.tools_for_layer(ltp.print_z()), nullptr, *print_object_instance_sequential_active - object.instances().data());
-                    print.throw_if_canceled();
+                std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>> layers_to_print;
+                for (LayerToPrint &ltp : collect_layers_to_print(object)) {
+                    coordf_t print_z = ltp.print_z();
+                    layers_to_print.emplace_back(print_z, std::vector<LayerToPrint>{ std::move(ltp) });
                 }
+                this->process_layers(print, tool_ordering, layers_to_print, nullptr, *print_object_instance_sequential_active - object.instances().data(), file);
 #ifdef HAS_PRESSURE_EQUALIZER
                 if (m_pressure_equalizer)
                     _write(file, m_pressure_equalizer->process("", true));
@@ -1629,13 +1651,7 @@ void GCode::_do_export(Print& print, FILE* file, ThumbnailsGeneratorCallback thu
                 print.throw_if_canceled();
             }
             // Extrude the layers.
-            for (auto &layer : layers_to_print) {
-                const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
-                if (m_wipe_tower && layer_tools.has_wipe_tower)
-                    m_wipe_tower->next_layer();
-                this->process_layer(file, print, print.m_print_statistics, layer.second, layer_tools, &print_object_instances_ordering, size_t(-1));
-                print.throw_if_canceled();
-            }
+            this->process_layers(print, tool_ordering, layers_to_print, &print_object_instances_ordering, size_t(-1), file);
 #ifdef HAS_PRESSURE_EQUALIZER
             if (m_pressure_equalizer)
                 _write(file, m_pressure_equalizer->process("", true));
@@ -2198,14 +2214,97 @@ namespace Skirt {
 
 } // namespace Skirt
 
+// Export the layers through a pipeline of serial stages: G-code generation (process_layer()), spiral vase,
+// cooling buffer and the output to the file (pressure equalizer, fan mover).
+// Each stage processes the layers in order, but the stages run concurrently: layer N is post-processed and written
+// while layer N+1 is being generated. The output is the same as if the layers were processed one after the other,
+// as the post-processors only keep their own state and take the tool used for the fan offset from the LayerResult.
+void GCode::process_layers(
+    Print                                                               &print,
+    const ToolOrdering                                                  &tool_ordering,
+    const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print,
+    // Pairs of PrintObject index and its instance index.
+    const std::vector<const PrintInstance*>                             *ordering,
+    // If set to size_t(-1), then print all copies of all objects.
+    // Otherwise print a single copy of a single object.
+    const size_t                                                         single_object_instance_idx,
+    // Write into the output file.
+    FILE                                                                *file)
+{
+    size_t layer_to_print_idx = 0;
+    const auto generator = tbb::make_filter<void, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &print, &tool_ordering, &layers_to_print, ordering, single_object_instance_idx, &layer_to_print_idx](tbb::flow_control &fc) -> LayerResult {
+            if (layer_to_print_idx == layers_to_print.size()) {
+                fc.stop();
+                return {};
+            }
+            print.throw_if_canceled();
+            const std::pair<coordf_t, std::vector<LayerToPrint>> &layer = layers_to_print[layer_to_print_idx ++];
+            const LayerTools &layer_tools = tool_ordering.tools_for_layer(layer.first);
+            if (m_wipe_tower && layer_tools.has_wipe_tower)
+                m_wipe_tower->next_layer();
+            if (m_wipe_tower && m_cooling_buffer)
+                // The previous layer went through the cooling buffer already, see max_layers_in_flight.
+                m_cooling_buffer->store_fan_speed(m_writer);
+            return this->process_layer(print, print.m_print_statistics, layer.second, layer_tools, ordering, single_object_instance_idx);
+        });
+    const auto spiral_vase = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this](LayerResult in) -> LayerResult {
+            if (in.nop_layer_result)
+                return in;
+            // Apply spiral vase post-processing if this layer contains suitable geometry
+            // (we must feed all the G-code into the post-processor, including the first
+            // bottom non-spiral layers otherwise it will mess with positions)
+            // we apply spiral vase at this stage because it requires a full layer.
+            // Just a reminder: A spiral vase mode is allowed for a single object per layer, single material print only.
+            if (m_spiral_vase) {
+                if (in.spiral_vase_enable)
+                    m_spiral_vase->enable(*in.spiral_vase_enable);
+                in.gcode = m_spiral_vase->process_layer(in.gcode);
+            }
+            // The milling moves are not spiralized.
+            in.gcode += in.milling_gcode;
+            in.milling_gcode.clear();
+            return in;
+        });
+    const auto cooling = tbb::make_filter<LayerResult, LayerResult>(slic3r_tbb_filtermode::serial_in_order,
+        [this](LayerResult in) -> LayerResult {
+            // Apply cooling logic; this may alter speeds.
+            if (m_cooling_buffer && ! in.nop_layer_result)
+                in.gcode = m_cooling_buffer->process_layer(in.gcode, in.layer_id, in.cooling_support_only, in.tool_id);
+            return in;
+        });
+    const auto output = tbb::make_filter<LayerResult, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this, file](LayerResult in) {
+            if (in.nop_layer_result)
+                return;
+#ifdef HAS_PRESSURE_EQUALIZER
+            // Apply pressure equalization if enabled;
+            if (m_pressure_equalizer)
+                in.gcode = m_pressure_equalizer->process(in.gcode.c_str(), false);
+#endif /* HAS_PRESSURE_EQUALIZER */
+            _write_layer(file, in.gcode, in.tool_id);
+        });
+
+    // The wipe tower integration restores the fan speed set by the cooling buffer of the previous layer:
+    // only one layer may be in flight then.
+    const size_t max_layers_in_flight = m_wipe_tower ? 1 : 12;
+    // The cooling stage keeps the fan speed for itself while the generator uses m_writer.
+    if (m_cooling_buffer)
+        m_cooling_buffer->load_fan_speed(m_writer);
+    tbb::parallel_pipeline(max_layers_in_flight, generator & spiral_vase & cooling & output);
+    if (m_cooling_buffer)
+        m_cooling_buffer->store_fan_speed(m_writer);
+    print.throw_if_canceled();
+}
+
 // In sequential mode, process_layer is called once per each object and its copy,
 // therefore layers will contain a single entry and single_object_instance_idx will point to the copy of the object.
 // In non-sequential mode, process_layer is called per each print_z height with all object and support layers accumulated.
 // For multi-material prints, this routine minimizes extruder switches by gathering extruder specific extrusion paths
 // and performing the extruder specific extrusions together.
-void GCode::process_layer(
-    // Write into the output file.
-    FILE                                    *file,
+// The returned G-code is not post-processed yet, see process_layers().
+GCode::LayerResult GCode::process_layer(
     const Print                             &print,
     PrintStatistics                         &print_stat,
     // Set of object & print layers of the same PrintObject and with the same print_z.
@@ -2223,7 +2322,7 @@ void GCode::process_layer(
 
     if (layer_tools.extruders.empty())
         // Nothing to extrude.
-        return;
+        return LayerResult::make_nop_layer_result();
 
     // Extract 1st object_layer and support_layer of this set of layers with an equal print_z.
     const Layer         *object_layer  = nullptr;
@@ -2242,6 +2341,10 @@ void GCode::process_layer(
     // Initialize config with the 1st object to be printed at this layer.
     m_config.apply(layer.object()->config(), true);
 
+    LayerResult result;
+    result.layer_id = layer.id();
+    result.cooling_support_only = support_layer != nullptr && object_layer == nullptr;
+
     // Check whether it is possible to apply the spiral vase logic for this layer.
     // Just a reminder: A spiral vase mode is allowed for a single object, single material print only.
     m_enable_loop_clipping = true;
@@ -2256,7 +2359,7 @@ void GCode::process_layer(
                     break;
                 }
         }
-        m_spiral_vase->enable(enable);
+        result.spiral_vase_enable = enable;
         // If we're going to apply spiralvase to this layer, disable loop clipping.
         m_enable_loop_clipping = !enable;
     }
@@ -2693,13 +2796,10 @@ void GCode::process_layer(
         }
     }
 
-    // Apply spiral vase post-processing if this layer contains suitable geometry
-    // (we must feed all the G-code into the post-processor, including the first
-    // bottom non-spiral layers otherwise it will mess with positions)
-    // we apply spiral vase at this stage because it requires a full layer.
-    // Just a reminder: A spiral vase mode is allowed for a single object per layer, single material print only.
-    if (m_spiral_vase)
-        gcode = m_spiral_vase->process_layer(gcode);
+    // The spiral vase post-processing is applied by process_layers() on the G-code generated so far,
+    // the milling G-code is appended after it.
+    result.gcode = std::move(gcode);
+    std::string &milling_gcode = result.milling_gcode;
 
 
     //add milling post-process if enabled
@@ -2717,11 +2817,11 @@ void GCode::process_layer(
         }
         if (milling_ok) {
             if (!m_gcode_label_objects_end.empty()) {
-                gcode += m_gcode_label_objects_end;
+                milling_gcode += m_gcode_label_objects_end;
                 m_gcode_label_objects_end = "";
             }
             //switch to mill
-            gcode += "; milling ok\n";
+            milling_gcode += "; milling ok\n";
             uint32_t current_extruder_filament = m_writer.tool()->id();
             uint32_t milling_extruder_id = uint32_t(config().nozzle_diameter.values.size());
             m_writer.toolchange(milling_extruder_id);
@@ -2736,11 +2836,11 @@ void GCode::process_layer(
                 config.set_key_value("previous_layer_z", new ConfigOptionFloat(previous_print_z));
                 config.set_key_value("layer_z", new ConfigOptionFloat(print_z));
                 // Process the start_mill_gcode for the new filament.
-                gcode += this->placeholder_parser_process("milling_toolchange_start_gcode", start_mill_gcode, current_extruder_filament, &config);
-                check_add_eol(gcode);
+                milling_gcode += this->placeholder_parser_process("milling_toolchange_start_gcode", start_mill_gcode, current_extruder_filament, &config);
+                check_add_eol(milling_gcode);
             }
 
-            gcode += "\n; began print:";
+            milling_gcode += "\n; began print:";
             for (const LayerToPrint& ltp : layers) {
                 if (ltp.object_layer != nullptr) {
                     for (const PrintInstance& print_instance : ltp.object()->instances()){
@@ -2748,8 +2848,8 @@ void GCode::process_layer(
                         for (const LayerRegion* lr : ltp.object_layer->regions()) {
                             if (!lr->milling.empty()) {
                                 //EXTRUDE MOVES
-                                gcode += "; extrude lr->milling\n";
-                                gcode += this->extrude_entity(lr->milling, "; milling post-process");
+                                milling_gcode += "; extrude lr->milling\n";
+                                milling_gcode += this->extrude_entity(lr->milling, "; milling post-process");
                             }
                         }
                     }
@@ -2768,10 +2868,10 @@ void GCode::process_layer(
                 config.set_key_value("previous_layer_z", new ConfigOptionFloat(previous_print_z));
                 config.set_key_value("layer_z", new ConfigOptionFloat(print_z));
                 // Process the end_mill_gcode for the new filament.
-                gcode += this->placeholder_parser_process("milling_toolchange_start_gcode", end_mill_gcode, current_extruder_filament, &config);
-                check_add_eol(gcode);
+                milling_gcode += this->placeholder_parser_process("milling_toolchange_start_gcode", end_mill_gcode, current_extruder_filament, &config);
+                check_add_eol(milling_gcode);
             }
-            gcode += "; will go back to normal extruder\n";
+            milling_gcode += "; will go back to normal extruder\n";
             m_writer.toolchange(current_extruder_filament);
             //TODO: change wipetower code to add an other filament change per layer.
             //gcode += (layer_tools.has_wipe_tower && m_wipe_tower) ?
@@ -2781,20 +2881,9 @@ void GCode::process_layer(
     }
 
 
-    // Apply cooling logic; this may alter speeds.
-    if (m_cooling_buffer)
-        gcode = m_cooling_buffer->process_layer(gcode, layer.id(), (support_layer != nullptr && object_layer == nullptr));
-
-#ifdef HAS_PRESSURE_EQUALIZER
-    // Apply pressure equalization if enabled;
-    // printf("G-code before filter:\n%s\n", gcode.c_str());
-    if (m_pressure_equalizer)
-        gcode = m_pressure_equalizer->process(gcode.c_str(), false);
-    // printf("G-code after filter:\n%s\n", out.c_str());
-#endif /* HAS_PRESSURE_EQUALIZER */
-
-    _write(file, gcode);
-    BOOST_LOG_TRIVIAL(trace) << "Exported layer " << layer.id() << " print_z " << print_z <<
+    // The post-processors use the fan offset of the tool active at the end of the layer.
+    result.tool_id = m_writer.tool() == nullptr ? 0 : m_writer.tool()->id();
+    BOOST_LOG_TRIVIAL(trace) << "Generated layer " << layer.id() << " print_z " << print_z <<
         log_memory_info();
 
 
@@ -2803,6 +2892,7 @@ void GCode::process_layer(
         m_last_status_update = std::chrono::system_clock::now();
         print.set_status(int((layer.id() * 100) / layer_count()), std::string(L("Generating G-code layer %s / %s")), std::vector<std::string>{ std::to_string(layer.id()), std::to_string(layer_count()) }, PrintBase::SlicingStatus::DEFAULT);
     }
+    return result;
 }
 
 void GCode::apply_print_config(const PrintConfig &print_config)
@@ -3445,14 +3535,22 @@ std::string GCode::extrude_entity(const ExtrusionEntity &entity, const std::stri
 }
 
 void GCode::use(const ExtrusionEntityCollection &collection) {
-    if (collection.no_sort || collection.role() == erMixed) {
+    ExtrusionRole role = collection.no_sort ? erMixed : collection.role();
+    if (role == erMixed) {
         for (const ExtrusionEntity* next_entity : collection.entities) {
             next_entity->visit(*this);
         }
     } else {
-        ExtrusionEntityCollection chained = collection.chained_path_from(m_last_pos);
-        for (const ExtrusionEntity* next_entity : chained.entities) {
-            next_entity->visit(*this);
+        // Same order as collection.chained_path_from(m_last_pos), but the collection is not cloned:
+        // only the entities to be extruded in the reverse direction are copied.
+        const ExtrusionEntitiesPtr entities = filter_by_extrusion_role(collection.entities, role);
+        for (const std::pair<size_t, bool> &idx : chain_extrusion_entities(entities, &m_last_pos)) {
+            if (idx.second) {
+                std::unique_ptr<ExtrusionEntity> reversed(entities[idx.first]->clone());
+                reversed->reverse();
+                reversed->visit(*this);
+            } else
+                entities[idx.first]->visit(*this);
         }
     }
 }
@@ -3634,7 +3732,7 @@ std::string GCode::extrude_support(const ExtrusionEntityCollection &support_fill
 }
 
 
-void GCode::_post_process(std::string& what, bool flush) {
+void GCode::_post_process(std::string& what, bool flush, uint16_t tool_id) {
 
     //if enabled, move the fan startup earlier.
     if (this->config().fan_speedup_time.value != 0 || this->config().fan_kickstart.value > 0) {
@@ -3646,7 +3744,7 @@ void GCode::_post_process(std::string& what, bool flush) {
                 this->config().use_relative_e_distances.value,
                 this->config().fan_speedup_overhangs.value,
                 (float)this->config().fan_kickstart.value));
-        what = this->m_fan_mover->process_gcode(what, flush);
+        what = this->m_fan_mover->process_gcode(what, flush, tool_id);
     }
 
 }
@@ -3657,13 +3755,27 @@ void GCode::_write(FILE* file, const char *what, bool flush /*=false*/)
         
         //const char * gcode_pp = _post_process(what).c_str();
         std::string str_preproc{ what };
-        _post_process(str_preproc, flush);
+        _post_process(str_preproc, flush, m_writer.tool() == nullptr ? 0 : m_writer.tool()->id());
         const char* gcode = str_preproc.c_str();
         // writes string to file
         fwrite(gcode, 1, ::strlen(gcode), file);
+#if ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
+        m_processor.process_buffer(str_preproc);
+#endif // ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
     }
 }
 
+void GCode::_write_layer(FILE* file, std::string& what, uint16_t tool_id)
+{
+    _post_process(what, false, tool_id);
+    const char* gcode = what.c_str();
+    // writes string to file
+    fwrite(gcode, 1, ::strlen(gcode), file);
+#if ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
+    m_processor.process_buffer(what);
+#endif // ENABLE_GCODE_PROCESSING_WHILE_EXPORTING
+}
+
 void GCode::_writeln(FILE* file, const std::string &what)
 {
     if (! what.empty())
@@ -24,6 +24,7 @@
 #include <map>
 #include <string>
 #include <chrono>
+#include <optional>
 
 #ifdef HAS_PRESSURE_EQUALIZER
 #include "GCode/PressureEqualizer.hpp"
@@ -205,9 +206,36 @@ private:
 
     static std::vector<LayerToPrint>        		                   collect_layers_to_print(const PrintObject &object);
     static std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>> collect_layers_to_print(const Print &print);
-    void            process_layer(
+
+    // G-code of a layer generated by process_layer(), passed through the post-processing stages of process_layers().
+    struct LayerResult {
+        std::string gcode;
+        // Milling G-code, appended after the spiral vase post-processing.
+        std::string milling_gcode;
+        size_t      layer_id { 0 };
+        // Set if this layer toggles the spiral vase post-processing.
+        std::optional<bool> spiral_vase_enable;
+        // Support only layer: the cooling buffer keeps its time separately.
+        bool        cooling_support_only { false };
+        // Tool active at the end of the layer, for the fan offset of the fan commands written by the post-processors.
+        uint16_t    tool_id { 0 };
+        // Nothing was extruded, the post-processors are skipped.
+        bool        nop_layer_result { false };
+
+        static LayerResult make_nop_layer_result() { LayerResult out; out.nop_layer_result = true; return out; }
+    };
+    void            process_layers(
+        Print                                                               &print,
+        const ToolOrdering                                                  &tool_ordering,
+        const std::vector<std::pair<coordf_t, std::vector<LayerToPrint>>>   &layers_to_print,
+        // Pairs of PrintObject index and its instance index.
+        const std::vector<const PrintInstance*>                             *ordering,
+        // If set to size_t(-1), then print all copies of all objects.
+        // Otherwise print a single copy of a single object.
+        const size_t                                                         single_object_idx,
         // Write into the output file.
-        FILE                            *file,
+        FILE                                                                *file);
+    LayerResult     process_layer(
         const Print                     &print,
         PrintStatistics                 &print_stat,
         // Set of object & print layers of the same PrintObject and with the same print_z.
@@ -424,9 +452,12 @@ private:
     // Processor
     GCodeProcessor m_processor;
 
-    // Write a string into a file.
+    // Write a string into a file. The written G-code is also passed to m_processor if ENABLE_GCODE_PROCESSING_WHILE_EXPORTING.
     void _write(FILE* file, const std::string& what, bool flush = false) { this->_write(file, what.c_str(), flush); }
     void _write(FILE* file, const char *what, bool flush = false);
+    // Write the G-code of a layer coming out of the process_layers() pipeline. The post-processors use the fan offset
+    // of tool_id instead of the active tool of m_writer, as the next layers are already being generated.
+    void _write_layer(FILE* file, std::string& what, uint16_t tool_id);
 
     // Write a string into a file. 
     // Add a newline, if the string does not end with a newline already.
@@ -438,7 +469,7 @@ private:
 
     //some post-processing on the file, with their data class
     std::unique_ptr<FanMover> m_fan_mover;
-    void _post_process(std::string& what, bool flush = true);
+    void _post_process(std::string& what, bool flush, uint16_t tool_id);
 
     std::string _extrude(const ExtrusionPath &path, const std::string &description, double speed = -1);
     std::string _before_extrude(const ExtrusionPath &path, const std::string &description, double speed = -1);
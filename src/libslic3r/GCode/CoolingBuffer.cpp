@@ -24,7 +24,7 @@ CoolingBuffer::CoolingBuffer(GCode &gcodegen) : m_gcodegen(gcodegen), m_current_
 
 void CoolingBuffer::reset()
 {
-    m_current_pos.assign(5, 0.f);
+    m_current_pos.fill(0.f);
     Vec3d pos = m_gcodegen.writer().get_position();
     m_current_pos[0] = float(pos(0));
     m_current_pos[1] = float(pos(1));
@@ -32,6 +32,28 @@ void CoolingBuffer::reset()
     m_current_pos[4] = float(m_gcodegen.config().travel_speed.value);
 }
 
+void CoolingBuffer::load_fan_speed(const GCodeWriter &writer)
+{
+    m_fan_speed             = writer.get_fan();
+    m_fan_speed_with_offset = writer.get_fan_with_offset();
+}
+
+void CoolingBuffer::store_fan_speed(GCodeWriter &writer) const
+{
+    writer.save_fan(m_fan_speed, m_fan_speed_with_offset);
+}
+
+std::string CoolingBuffer::set_fan(uint8_t speed)
+{
+    GCodeWriter &writer            = m_gcodegen.writer();
+    uint8_t      speed_with_offset = writer.fan_speed_for_tool(speed, m_fan_tool_id);
+    if (speed_with_offset == m_fan_speed_with_offset)
+        return {};
+    m_fan_speed             = speed;
+    m_fan_speed_with_offset = speed_with_offset;
+    return writer.set_fan_for_tool(speed, m_fan_tool_id, true);
+}
+
 struct CoolingLine
 {
     enum Type : uint32_t {
@@ -293,8 +315,9 @@ finished:
 	return new_feedrate;
 }
 
-std::string CoolingBuffer::process_layer(const std::string &gcode, size_t layer_id, bool is_support_only)
+std::string CoolingBuffer::process_layer(const std::string &gcode, size_t layer_id, bool is_support_only, uint16_t fan_tool_id)
 {
+    m_fan_tool_id = fan_tool_id;
     auto& previous_layer_time = is_support_only ? saved_layer_time_object : saved_layer_time_support;
     auto my_previous_layer_time = is_support_only ? saved_layer_time_support : saved_layer_time_object;
     auto& my_layer_time = is_support_only ? saved_layer_time_support : saved_layer_time_object;
@@ -337,7 +360,7 @@ std::string CoolingBuffer::process_layer(const std::string &gcode, size_t layer_
 
 // Parse the layer G-code for the moves, which could be adjusted.
 // Return the list of parsed lines, bucketed by an extruder.
-std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const
+std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::string &gcode, std::array<float, 5> &current_pos) const
 {
     const FullPrintConfig       &config        = m_gcodegen.config();
     const std::vector<Extruder> &extruders     = m_gcodegen.writer().extruders();
@@ -372,8 +395,8 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
     {
         while (*line_end != '\n' && *line_end != 0)
             ++ line_end;
-        // sline will not contain the trailing '\n'.
-        std::string sline(line_start, line_end);
+        // sline will not contain the trailing '\n'. It is a view into the layer G-code, no copy is made.
+        std::string_view sline(line_start, line_end - line_start);
         // CoolingLine will contain the trailing '\n'.
         if (*line_end == '\n')
             ++ line_end;
@@ -387,12 +410,13 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
         if (line.type) {
             // G0, G1 or G92
             // Parse the G-code line.
-            std::vector<float> new_pos(current_pos);
-            const char *c = sline.data() + 3;
+            std::array<float, 5> new_pos = current_pos;
+            const char *c     = sline.data() + 3;
+            const char *c_end = sline.data() + sline.size();
             for (;;) {
                 // Skip whitespaces.
-                for (; *c == ' ' || *c == '\t'; ++ c);
-                if (*c == 0 || *c == ';')
+                for (; c != c_end && (*c == ' ' || *c == '\t'); ++ c);
+                if (c == c_end || *c == ';')
                     break;
                 // Parse the axis.
                 size_t axis = (*c >= 'X' && *c <= 'Z') ? (*c - 'X') :
@@ -408,7 +432,7 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                     }
                 }
                 // Skip this word.
-                for (; *c != ' ' && *c != '\t' && *c != 0; ++ c);
+                for (; c != c_end && *c != ' ' && *c != '\t'; ++ c);
             }
             bool external_perimeter = boost::contains(sline, ";_EXTERNAL_PERIMETER");
             bool wipe               = boost::contains(sline, ";_WIPE");
@@ -464,12 +488,12 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
                     line.type = 0;
                 }
             }
-            current_pos = std::move(new_pos);
+            current_pos = new_pos;
         } else if (boost::starts_with(sline, ";_EXTRUDE_END")) {
             line.type = CoolingLine::TYPE_EXTRUDE_END;
             active_speed_modifier = size_t(-1);
         } else if (boost::starts_with(sline, toolchange_prefix)) {
-            uint16_t new_extruder = (uint16_t)atoi(sline.c_str() + toolchange_prefix.size());
+            uint16_t new_extruder = (uint16_t)atoi(sline.data() + toolchange_prefix.size());
             // Only change extruder in case the number is meaningful. User could provide an out-of-range index through custom gcodes - those shall be ignored.
             if (new_extruder < map_extruder_to_per_extruder_adjustment.size()) {
                 if (new_extruder != current_extruder) {
@@ -503,8 +527,8 @@ std::vector<PerExtruderAdjustments> CoolingBuffer::parse_layer_gcode(const std::
             size_t pos_S = sline.find('S', 3);
             size_t pos_P = sline.find('P', 3);
             line.time = line.time_max = float(
-                (pos_S > 0) ? atof(sline.c_str() + pos_S + 1) :
-                (pos_P > 0) ? atof(sline.c_str() + pos_P + 1) * 0.001 : 0.);
+                (pos_S > 0) ? atof(sline.data() + pos_S + 1) :
+                (pos_P > 0) ? atof(sline.data() + pos_P + 1) * 0.001 : 0.);
         }
         if (line.type != 0)
             adjustment->lines.emplace_back(std::move(line));
@@ -837,7 +861,7 @@ std::string CoolingBuffer::apply_layer_cooldown(
         }
         if (fan_speed_new != fan_speed) {
             fan_speed = fan_speed_new;
-            new_gcode += m_gcodegen.writer().set_fan(fan_speed);
+            new_gcode += this->set_fan(fan_speed);
         }
     };
     //set to know all fan modifiers that can be applied ( TYPE_BRIDGE_FAN_END, TYPE_TOP_FAN_START, TYPE_EXTERNAL_PERIMETER).
@@ -974,15 +998,15 @@ std::string CoolingBuffer::apply_layer_cooldown(
         if (fan_need_set) {
             //choose the speed with highest priority
             if (current_fan_sections.find(CoolingLine::TYPE_BRIDGE_FAN_START) != current_fan_sections.end())
-                new_gcode += m_gcodegen.writer().set_fan(bridge_fan_speed);
+                new_gcode += this->set_fan(bridge_fan_speed);
             else if (current_fan_sections.find(CoolingLine::TYPE_BRIDGE_INTERNAL_FAN_START) != current_fan_sections.end())
-                new_gcode += m_gcodegen.writer().set_fan(bridge_internal_fan_speed);
+                new_gcode += this->set_fan(bridge_internal_fan_speed);
             else if (current_fan_sections.find(CoolingLine::TYPE_TOP_FAN_START) != current_fan_sections.end())
-                new_gcode += m_gcodegen.writer().set_fan(top_fan_speed);
+                new_gcode += this->set_fan(top_fan_speed);
             else if (current_fan_sections.find(CoolingLine::TYPE_EXTERNAL_PERIMETER) != current_fan_sections.end())
-                new_gcode += m_gcodegen.writer().set_fan(ext_peri_fan_speed);
+                new_gcode += this->set_fan(ext_peri_fan_speed);
             else
-                new_gcode += m_gcodegen.writer().set_fan(fan_speed);
+                new_gcode += this->set_fan(fan_speed);
             fan_need_set = false;
         }
         pos = line_end;
@@ -2,12 +2,14 @@
 #define slic3r_CoolingBuffer_hpp_
 
 #include "../libslic3r.h"
+#include <array>
 #include <map>
 #include <string>
 
 namespace Slic3r {
 
 class GCode;
+class GCodeWriter;
 class Layer;
 struct PerExtruderAdjustments;
 
@@ -27,24 +29,38 @@ public:
     void        set_current_extruder(unsigned int extruder_id) { m_current_extruder = extruder_id; }
     /// process the laer :check the time and apply fan / speed change
     /// append_time_only: if he layer is only support, then you can put this at true to not process the layer but just append its time to the next one.
-    std::string process_layer(const std::string &gcode, size_t layer_id, bool append_time_only = false);
+    /// fan_tool_id: tool active at the end of the layer, its fan offset is applied to the fan commands.
+    std::string process_layer(const std::string &gcode, size_t layer_id, bool append_time_only, uint16_t fan_tool_id);
     GCode* 	    gcodegen() { return &m_gcodegen; }
+    // The fan speed is tracked by this buffer while the layers are processed, as the export pipeline runs the cooling
+    // stage concurrently with the G-code generation using the GCodeWriter. It is taken from the writer before the layers
+    // are processed and given back to it by the G-code generator thread.
+    void        load_fan_speed(const GCodeWriter &writer);
+    void        store_fan_speed(GCodeWriter &writer) const;
 
 private:
 	CoolingBuffer& operator=(const CoolingBuffer&) = delete;
-    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::vector<float> &current_pos) const;
+    std::vector<PerExtruderAdjustments> parse_layer_gcode(const std::string &gcode, std::array<float, 5> &current_pos) const;
     float       calculate_layer_slowdown(std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
     // Apply slow down over G-code lines stored in per_extruder_adjustments, enable fan if needed.
     // Returns the adjusted G-code.
     std::string apply_layer_cooldown(const std::string &gcode, size_t layer_id, float layer_time, std::vector<PerExtruderAdjustments> &per_extruder_adjustments);
+    // Write the fan speed if it changed, without saving it into the GCodeWriter.
+    std::string set_fan(uint8_t speed);
 
     GCode&              m_gcodegen;
     std::string         m_gcode;
     // Internal data.
     // X,Y,Z,E,F
     std::vector<char>   m_axis;
-    std::vector<float>  m_current_pos;
+    std::array<float, 5> m_current_pos;
     unsigned int        m_current_extruder;
+    // Tool given to process_layer(), for the fan offset. Not read from the GCodeWriter, as the export pipeline
+    // generates the next layers while this one is being processed.
+    uint16_t            m_fan_tool_id = 0;
+    // Last fan speed written, with and without the fan offset of its tool.
+    uint8_t             m_fan_speed = 0;
+    uint8_t             m_fan_speed_with_offset = 0;
 
     //saved previous unslowed layer 
     std::map<size_t, float> saved_layer_time_support;
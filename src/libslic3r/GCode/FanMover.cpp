@@ -19,9 +19,10 @@
 
 namespace Slic3r {
 
-const std::string& FanMover::process_gcode(const std::string& gcode, bool flush)
+const std::string& FanMover::process_gcode(const std::string& gcode, bool flush, uint16_t tool_id)
 {
     m_process_output = "";
+    m_tool_id = tool_id;
 
     // recompute buffer time to recover from rounding
     m_buffer_time_size = 0;
@@ -263,10 +264,10 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                 _remove_slow_fan(fan_baseline, kickstart);
                                 // print me
                                 if (!m_buffer.empty() && (m_buffer_time_size - m_buffer.front().time * 0.1) > nb_seconds_delay) {
-                                    _print_in_middle_G1(m_buffer.front(), m_buffer_time_size - nb_seconds_delay, m_writer.set_fan(100, true));
+                                    _print_in_middle_G1(m_buffer.front(), m_buffer_time_size - nb_seconds_delay, m_writer.set_fan_for_tool(100, m_tool_id, true));
                                     remove_from_buffer(m_buffer.begin());
                                 } else {
-                                    m_process_output += m_writer.set_fan(100, true);
+                                    m_process_output += m_writer.set_fan_for_tool(100, m_tool_id, true);
                                 }
                                 //write it in the queue if possible
                                 const float kickstart_duration = kickstart * float(fan_speed - m_front_buffer_fan_speed) / 100.f;
@@ -327,7 +328,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
                                 float kickstart_duration = kickstart * float(fan_speed - m_back_buffer_fan_speed) / 100.f;
                                 //if kickstart, write the M106 S[fan_baseline] first
                                 //set the target speed and set the kickstart flag
-                                put_in_buffer(BufferData(m_writer.set_fan(100, true), 0, fan_speed, true));
+                                put_in_buffer(BufferData(m_writer.set_fan_for_tool(100, m_tool_id, true), 0, fan_speed, true));
                                 //kickstart!
                                 //m_process_output += m_writer.set_fan(100, true);
                                 //add the normal speed line for the future
@@ -424,7 +425,7 @@ void FanMover::_process_gcode_line(GCodeReader& reader, const GCodeReader::GCode
             if (frontdata.fan_speed < 0 || frontdata.fan_speed != m_front_buffer_fan_speed || frontdata.is_kickstart) {
                 if (frontdata.is_kickstart && frontdata.fan_speed < m_front_buffer_fan_speed) {
                     //you have to slow down! not kickstart! rewrite the fan speed.
-                    m_process_output += m_writer.set_fan(frontdata.fan_speed,true);
+                    m_process_output += m_writer.set_fan_for_tool(frontdata.fan_speed, m_tool_id, true);
                     m_front_buffer_fan_speed = frontdata.fan_speed;
                 } else {
                     m_process_output += frontdata.raw + "\n";
@@ -39,6 +39,8 @@ private:
 
     GCodeReader m_parser{};
     GCodeWriter& m_writer;
+    // tool used for the fan offset of the fan commands written by this filter (set by process_gcode)
+    uint16_t m_tool_id = 0;
 
     //current value (at the back of the buffer), when parsing a new line
     ExtrusionRole current_role = ExtrusionRole::erCustom;
@@ -67,12 +69,13 @@ public:
         , relative_e(relative_e), only_overhangs(only_overhangs), kickstart(kickstart), m_writer(writer){}
 
     // Adds the gcode contained in the given string to the analysis and returns it after removing the workcodes
-    const std::string& process_gcode(const std::string& gcode, bool flush);
+    // tool_id: the tool active at the end of this gcode, its fan offset is used for the fan commands.
+    const std::string& process_gcode(const std::string& gcode, bool flush, uint16_t tool_id);
 
 private:
     BufferData& put_in_buffer(BufferData&& data) {
         m_buffer_time_size += data.time;
-        m_buffer.emplace_back(data);
+        m_buffer.emplace_back(std::move(data));
         return m_buffer.back();
     }
     std::list<BufferData>::iterator remove_from_buffer(std::list<BufferData>::iterator data) {
@@ -873,12 +873,9 @@ void GCodeProcessor::reset()
 }
 void GCodeProcessor::process_string(const std::string& gcode, std::function<void()> cancel_callback)
 {
-    std::stringstream ss(gcode);
-    std::string strline;
-    while ( std::getline(ss, strline))
-        m_parser.parse_line(strline, [this](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
-            process_gcode_line(line); 
-        });
+    m_parser.parse_buffer(gcode, [this](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
+        process_gcode_line(line);
+    });
 }
 
 void GCodeProcessor::process_file(const std::string& filename, bool apply_postprocess, std::function<void()> cancel_callback)
@@ -886,7 +883,7 @@ void GCodeProcessor::process_file(const std::string& filename, bool apply_postpr
     auto last_cancel_callback_time = std::chrono::high_resolution_clock::now();
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
-    auto start_time = std::chrono::high_resolution_clock::now();
+    m_start_time = std::chrono::high_resolution_clock::now();
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 
     // pre-processing
@@ -923,7 +920,8 @@ void GCodeProcessor::process_file(const std::string& filename, bool apply_postpr
     m_result.id = ++s_result_id;
     // 1st move must be a dummy move
     m_result.moves.emplace_back(MoveVertex());
-    m_parser.parse_file(filename, [this, cancel_callback, &last_cancel_callback_time](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
+    // The file is tokenized in parallel, the lines are processed here in order.
+    m_parser.parse_file_parallel(filename, [this, cancel_callback, &last_cancel_callback_time](GCodeReader& reader, const GCodeReader::GCodeLine& line) {
         if (cancel_callback != nullptr) {
             // call the cancel callback every 100 ms
             auto curr_time = std::chrono::high_resolution_clock::now();
@@ -935,6 +933,48 @@ void GCodeProcessor::process_file(const std::string& filename, bool apply_postpr
         process_gcode_line(line);
         });
 
+    this->finalize(filename, apply_postprocess, cancel_callback);
+}
+
+void GCodeProcessor::initialize()
+{
+#if ENABLE_GCODE_VIEWER_STATISTICS
+    m_start_time = std::chrono::high_resolution_clock::now();
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
+
+    m_buffer_tail.clear();
+    m_result.id = ++s_result_id;
+    // 1st move must be a dummy move
+    m_result.moves.emplace_back(MoveVertex());
+}
+
+void GCodeProcessor::process_buffer(const std::string& buffer)
+{
+    auto process_line = [this](GCodeReader& reader, const GCodeReader::GCodeLine& line) { process_gcode_line(line); };
+    // Only complete lines are processed, the rest is kept in m_buffer_tail until the end of its line is received.
+    size_t last_eol = buffer.rfind('\n');
+    if (last_eol == std::string::npos) {
+        m_buffer_tail += buffer;
+        return;
+    }
+    size_t start = 0;
+    if (! m_buffer_tail.empty()) {
+        start = buffer.find('\n') + 1;
+        m_buffer_tail.append(buffer, 0, start);
+        m_parser.parse_buffer(m_buffer_tail, process_line);
+    }
+    m_parser.parse_buffer(buffer.c_str() + start, buffer.c_str() + last_eol + 1, process_line);
+    m_buffer_tail.assign(buffer, last_eol + 1, std::string::npos);
+}
+
+void GCodeProcessor::finalize(const std::string& filename, bool apply_postprocess, std::function<void()> cancel_callback)
+{
+    // the last line of an exported file may not be terminated
+    if (! m_buffer_tail.empty()) {
+        m_parser.parse_buffer(m_buffer_tail, [this](GCodeReader& reader, const GCodeReader::GCodeLine& line) { process_gcode_line(line); });
+        m_buffer_tail.clear();
+    }
+
     // update width/height of wipe moves
     for (MoveVertex& move : m_result.moves) {
         if (move.type == EMoveType::Wipe) {
@@ -955,8 +995,11 @@ void GCodeProcessor::process_file(const std::string& filename, bool apply_postpr
     update_estimated_times_stats();
 
     // post-process to add M73 lines into the gcode
-    if (apply_postprocess)
+    if (apply_postprocess) {
+        if (cancel_callback != nullptr)
+            cancel_callback();
         m_time_processor.post_process(filename);
+    }
 
     //update times for results
     for (size_t i = 0; i < m_result.moves.size(); i++) {
@@ -975,7 +1018,7 @@ void GCodeProcessor::process_file(const std::string& filename, bool apply_postpr
 #endif // ENABLE_GCODE_VIEWER_DATA_CHECKING
 
 #if ENABLE_GCODE_VIEWER_STATISTICS
-    m_result.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - start_time).count();
+    m_result.time = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::high_resolution_clock::now() - m_start_time).count();
 #endif // ENABLE_GCODE_VIEWER_STATISTICS
 }
 
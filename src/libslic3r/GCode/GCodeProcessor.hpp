@@ -395,6 +395,11 @@ namespace Slic3r {
 
     private:
         GCodeReader m_parser;
+        // Unfinished last line of the buffer given to process_buffer(), waiting for the rest of it.
+        std::string m_buffer_tail;
+#if ENABLE_GCODE_VIEWER_STATISTICS
+        std::chrono::time_point<std::chrono::high_resolution_clock> m_start_time;
+#endif // ENABLE_GCODE_VIEWER_STATISTICS
 
         EUnits m_units;
         EPositioningType m_global_positioning_type;
@@ -481,6 +486,14 @@ namespace Slic3r {
         void process_file(const std::string& filename, bool apply_postprocess, std::function<void()> cancel_callback = nullptr);
         void process_string(const std::string& gcode, std::function<void()> cancel_callback = nullptr);
 
+        // Process the gcode while it is being exported, instead of reading the exported file back with process_file():
+        // initialize() before the first line is written, process_buffer() with the G-code in the order it is written
+        // and finalize() once the file with the given filename has been closed.
+        // The result is the same as the one of process_file() on that file.
+        void initialize();
+        void process_buffer(const std::string& buffer);
+        void finalize(const std::string& filename, bool apply_postprocess, std::function<void()> cancel_callback = nullptr);
+
         float get_time(PrintEstimatedTimeStatistics::ETimeMode mode) const;
         std::string get_time_dhm(PrintEstimatedTimeStatistics::ETimeMode mode) const;
         std::vector<std::pair<CustomGCode::Type, std::pair<float, float>>> get_custom_gcode_times(PrintEstimatedTimeStatistics::ETimeMode mode, bool include_remaining) const;
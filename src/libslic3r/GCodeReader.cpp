@@ -1,10 +1,23 @@
 #include "GCodeReader.hpp"
+#include "Utils.hpp"
 #include <boost/algorithm/string/classification.hpp>
 #include <boost/algorithm/string/split.hpp>
+#include <boost/nowide/cstdio.hpp>
 #include <boost/nowide/fstream.hpp>
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+
+#include <tbb/parallel_for.h>
+#if TBB_VERSION_MAJOR >= 2021
+    #include <tbb/parallel_pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter_mode;
+#else
+    #include <tbb/pipeline.h>
+    using slic3r_tbb_filtermode = tbb::filter;
+#endif
 
 #include <Shiny/Shiny.h>
 
@@ -25,11 +38,44 @@ void GCodeReader::apply_config(const DynamicPrintConfig &config)
 const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command)
 {
     PROFILE_FUNC();
-    
+
+    const char *end = this->tokenize_line(ptr, gline, command);
+
+    if (gline.has(E) && m_config.use_relative_e_distances)
+        m_position[E] = 0;
+
+    if (m_verbose)
+        std::cout << gline.m_raw << std::endl;
+
+    return end;
+}
+
+// Skip the trailing newlines of a line.
+static const char* skip_newlines(const char *c)
+{
+    if (*c == '\r')
+        ++ c;
+    if (*c == '\n')
+        ++ c;
+    return c;
+}
+
+const char* GCodeReader::tokenize_line(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command) const
+{
+    const char *c = this->tokenize_axes(ptr, gline.m_axis, gline.m_mask, command);
+
+    // Copy the raw string including the comment, without the trailing newlines.
+    if (c > ptr)
+        gline.m_raw.assign(ptr, c);
+
+    return skip_newlines(c);
+}
+
+const char* GCodeReader::tokenize_axes(const char *ptr, float *axis_values, uint32_t &mask, std::pair<const char*, const char*> &command) const
+{
     // command and args
     const char *c = ptr;
     {
-        PROFILE_BLOCK(command_and_args);
         // Skip the whitespaces.
         command.first = skip_whitespaces(c);
         // Skip the command.
@@ -62,8 +108,8 @@ const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline,
                 if (pend != nullptr && is_end_of_word(*pend)) {
                     // The axis value has been parsed correctly.
                     if (axis != UNKNOWN_AXIS)
-	                    gline.m_axis[int(axis)] = float(v);
-                    gline.m_mask |= 1 << int(axis);
+	                    axis_values[int(axis)] = float(v);
+                    mask |= 1 << int(axis);
                     c = pend;
                 } else
                     // Skip the rest of the word.
@@ -73,28 +119,10 @@ const char* GCodeReader::parse_line_internal(const char *ptr, GCodeLine &gline,
                 c = skip_word(c);
         }
     }
-    
-    if (gline.has(E) && m_config.use_relative_e_distances)
-        m_position[E] = 0;
 
     // Skip the rest of the line.
     for (; ! is_end_of_line(*c); ++ c);
 
-    // Copy the raw string including the comment, without the trailing newlines.
-    if (c > ptr) {
-        PROFILE_BLOCK(copy_raw_string);
-        gline.m_raw.assign(ptr, c);
-    }
-
-    // Skip the trailing newlines.
-	if (*c == '\r')
-		++ c;
-	if (*c == '\n')
-		++ c;
-
-    if (m_verbose)
-        std::cout << gline.m_raw << std::endl;
-
     return c;
 }
 
@@ -112,13 +140,140 @@ void GCodeReader::update_coordinates(GCodeLine &gline, std::pair<const char*, co
     }
 }
 
+// Size of the blocks of a G-code file read by parse_file() and parse_file_parallel().
+static constexpr size_t gcode_file_block_size = 1 << 20;
+
+// Read the next block of complete lines of a G-code file into block, followed by a zero character.
+// The unfinished last line is moved to unfinished, to start the next block. Returns false at the end of the file.
+static bool read_lines_block(FILE *f, std::vector<char> &block, std::vector<char> &unfinished)
+{
+    block.swap(unfinished);
+    unfinished.clear();
+    for (;;) {
+        size_t size = block.size();
+        block.resize(size + gcode_file_block_size);
+        size_t read = fread(block.data() + size, 1, gcode_file_block_size, f);
+        block.resize(size + read);
+        if (read == 0) {
+            // End of file, the last line is not terminated by a newline.
+            bool not_empty = ! block.empty();
+            block.push_back(0);
+            return not_empty;
+        }
+        auto last_eol = std::find(block.rbegin(), block.rbegin() + read, '\n');
+        if (last_eol != block.rbegin() + read) {
+            // last_eol.base() points just after the newline.
+            unfinished.assign(last_eol.base(), block.end());
+            block.erase(last_eol.base(), block.end());
+            block.push_back(0);
+            return true;
+        }
+        // A line longer than the block, read further.
+    }
+}
+
+// Skip the rest of a line containing a zero character, which ended the parsing of the line too early.
+static const char* skip_zero_in_line(const char *ptr, const char *end)
+{
+    if (ptr < end && *ptr == 0) {
+        for (; ptr < end && *ptr != '\n'; ++ ptr) ;
+        if (ptr < end)
+            ++ ptr;
+    }
+    return ptr;
+}
+
 void GCodeReader::parse_file(const std::string &file, callback_t callback)
 {
-    boost::nowide::ifstream f(file);
-    std::string line;
+    FILE *f = boost::nowide::fopen(file.c_str(), "rb");
+    if (f == nullptr)
+        return;
+    // The callback may throw, for example on cancellation.
+    ScopeGuard close_file([f]() { fclose(f); });
+
+    // The lines are parsed in place in large blocks, with a single GCodeLine reused for all of them,
+    // so that no memory is allocated per line.
+    std::vector<char> block;
+    std::vector<char> unfinished;
+    GCodeLine         gline;
     m_parsing_file = true;
-    while (m_parsing_file && std::getline(f, line))
-        this->parse_line(line, callback);
+    while (m_parsing_file && read_lines_block(f, block, unfinished)) {
+        const char *ptr = block.data();
+        const char *end = ptr + block.size() - 1;
+        while (m_parsing_file && ptr < end) {
+            gline.reset();
+            ptr = skip_zero_in_line(this->parse_line(ptr, gline, callback), end);
+        }
+    }
+}
+
+void GCodeReader::parse_file_parallel(const std::string &file, callback_t callback)
+{
+    FILE *f = boost::nowide::fopen(file.c_str(), "rb");
+    if (f == nullptr)
+        return;
+    ScopeGuard close_file([f]() { fclose(f); });
+
+    // A line tokenized in parallel. Its raw text points into the text of its block, so that no memory is allocated per line.
+    struct TokenizedLine {
+        std::string_view                     raw;
+        std::pair<const char*, const char*>  command;
+        float                                axis[NUM_AXES] {};
+        uint32_t                             mask { 0 };
+    };
+    struct Block {
+        std::vector<char>          text;
+        std::vector<TokenizedLine> lines;
+    };
+    using BlockPtr = std::shared_ptr<Block>;
+
+    // Read the blocks of the file in order.
+    std::vector<char> unfinished;
+    bool              eof = false;
+    const auto reader = tbb::make_filter<void, BlockPtr>(slic3r_tbb_filtermode::serial_in_order,
+        [f, &unfinished, &eof](tbb::flow_control &fc) -> BlockPtr {
+            auto block = std::make_shared<Block>();
+            if (eof || ! read_lines_block(f, block->text, unfinished)) {
+                eof = true;
+                fc.stop();
+                return nullptr;
+            }
+            return block;
+        });
+    // Split the blocks into lines and parse the axis values. This does not depend on the state of the reader,
+    // thus the blocks are tokenized in parallel.
+    const auto tokenizer = tbb::make_filter<BlockPtr, BlockPtr>(slic3r_tbb_filtermode::parallel,
+        [this](BlockPtr block) -> BlockPtr {
+            const char *ptr = block->text.data();
+            const char *end = ptr + block->text.size() - 1;
+            while (ptr < end) {
+                TokenizedLine &line = block->lines.emplace_back();
+                const char    *eol  = this->tokenize_axes(ptr, line.axis, line.mask, line.command);
+                line.raw = std::string_view(ptr, eol - ptr);
+                ptr = skip_zero_in_line(skip_newlines(eol), end);
+            }
+            return block;
+        });
+    // Update the position of the reader and call back, line by line in the order of the file.
+    // The lines are passed to the callback through a single GCodeLine, like parse_file() does.
+    GCodeLine gline;
+    const auto consumer = tbb::make_filter<BlockPtr, void>(slic3r_tbb_filtermode::serial_in_order,
+        [this, &callback, &gline](BlockPtr block) {
+            for (TokenizedLine &line : block->lines) {
+                gline.m_raw.assign(line.raw.data(), line.raw.size());
+                std::copy(std::begin(line.axis), std::end(line.axis), gline.m_axis);
+                gline.m_mask = line.mask;
+                if (gline.has(E) && m_config.use_relative_e_distances)
+                    m_position[E] = 0;
+                if (m_verbose)
+                    std::cout << gline.m_raw << std::endl;
+                callback(*this, gline);
+                update_coordinates(gline, line.command);
+            }
+        });
+
+    // Limit the number of blocks in memory.
+    tbb::parallel_pipeline(16, reader & tokenizer & consumer);
 }
 
 bool GCodeReader::GCodeLine::has(char axis) const
@@ -98,6 +98,18 @@ public:
         }
     }
 
+    // Parse the lines of [begin, end), end has to point just after an end of line.
+    template<typename Callback>
+    void parse_buffer(const char *begin, const char *end, Callback callback)
+    {
+        const char *ptr = begin;
+        GCodeLine gline;
+        while (ptr < end) {
+            gline.reset();
+            ptr = this->parse_line(ptr, gline, callback);
+        }
+    }
+
     void parse_buffer(const std::string &buffer)
         { this->parse_buffer(buffer, [](GCodeReader&, const GCodeReader::GCodeLine&){}); }
 
@@ -116,6 +128,10 @@ public:
         { GCodeLine gline; this->parse_line(line.c_str(), gline, callback); }
 
     void parse_file(const std::string &file, callback_t callback);
+    // Like parse_file(), but the blocks of the file are split into lines and tokenized in parallel,
+    // while the callback is called from a single thread at a time, with the lines in the order of the file.
+    // quit_parsing_file() is not supported, the whole file is parsed.
+    void parse_file_parallel(const std::string &file, callback_t callback);
     void quit_parsing_file() { m_parsing_file = false; }
 
     float& x()       { return m_position[X]; }
@@ -134,6 +150,10 @@ public:
 
 private:
     const char* parse_line_internal(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command);
+    // Split the line into the command and the axis values. Unlike parse_line_internal(), the state of the reader is not modified.
+    const char* tokenize_line(const char *ptr, GCodeLine &gline, std::pair<const char*, const char*> &command) const;
+    // Like tokenize_line(), but the raw text of the line is not copied. Returns the end of the line before the trailing newlines.
+    const char* tokenize_axes(const char *ptr, float *axis, uint32_t &mask, std::pair<const char*, const char*> &command) const;
     void        update_coordinates(GCodeLine &gline, std::pair<const char*, const char*> &command);
 
     static bool         is_whitespace(char c)           { return c == ' ' || c == '\t'; }
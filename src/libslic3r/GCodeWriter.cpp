@@ -247,14 +247,28 @@ std::string GCodeWriter::set_bed_temperature(uint32_t temperature, bool wait)
 
 std::string GCodeWriter::set_fan(const uint8_t speed, bool dont_save, uint16_t default_tool)
 {
-    std::ostringstream gcode;
+    return this->_set_fan(speed, dont_save, m_tool == nullptr ? get_tool(default_tool) : m_tool);
+}
+
+std::string GCodeWriter::set_fan_for_tool(const uint8_t speed, uint16_t tool_id, bool dont_save)
+{
+    return this->_set_fan(speed, dont_save, get_tool(tool_id));
+}
 
-    const Tool *tool = m_tool == nullptr ? get_tool(default_tool) : m_tool;
+uint8_t GCodeWriter::_fan_speed_with_offset(const uint8_t speed, const Tool *tool) const
+{
     //add fan_offset
     int8_t fan_speed = int8_t(std::min(uint8_t(100), speed));
     if (tool != nullptr)
         fan_speed += tool->fan_offset();
-    fan_speed = std::max(int8_t(0), std::min(int8_t(100), fan_speed));
+    return uint8_t(std::max(int8_t(0), std::min(int8_t(100), fan_speed)));
+}
+
+std::string GCodeWriter::_set_fan(const uint8_t speed, bool dont_save, const Tool *tool)
+{
+    std::ostringstream gcode;
+
+    const int8_t fan_speed = int8_t(this->_fan_speed_with_offset(speed, tool));
     const auto fan_baseline = (this->config.fan_percentage.value ? 100.0 : 255.0);
 
     // fan_speed has an effective minimum value of 0, so this cast is safe.
@@ -46,9 +46,18 @@ public:
     std::string postamble() const;
     std::string set_temperature(int16_t temperature, bool wait = false, int tool = -1);
     std::string set_bed_temperature(uint32_t temperature, bool wait = false);
-    uint8_t get_fan() { return m_last_fan_speed; }
+    uint8_t get_fan() const { return m_last_fan_speed; }
     /// set fan at speed. Save it as current fan speed if !dont_save, and use tool default_tool if the internal m_tool is null (no toolchange done yet).
     std::string set_fan(uint8_t speed, bool dont_save = false, uint16_t default_tool = 0);
+    /// same as set_fan, but use the fan offset of the tool tool_id instead of the internal m_tool.
+    /// Used by the post-processors of the G-code export pipeline, as m_tool may already be changed by the generation of the next layers.
+    std::string set_fan_for_tool(uint8_t speed, uint16_t tool_id, bool dont_save = false);
+    /// fan speed written by set_fan_for_tool(speed, tool_id): speed with the fan offset of the tool tool_id.
+    uint8_t     fan_speed_for_tool(uint8_t speed, uint16_t tool_id) const { return this->_fan_speed_with_offset(speed, get_tool(tool_id)); }
+    /// current fan speed with the fan offset, to be compared with fan_speed_for_tool().
+    uint8_t     get_fan_with_offset() const { return m_last_fan_speed_with_offset; }
+    /// save the current fan speed without writing anything, for a fan set by a post-processor with dont_save.
+    void        save_fan(uint8_t speed, uint8_t speed_with_offset) { m_last_fan_speed = speed; m_last_fan_speed_with_offset = speed_with_offset; }
     void        set_acceleration(uint32_t acceleration);
     uint32_t    get_acceleration() const;
     std::string write_acceleration();
@@ -100,6 +109,8 @@ private:
     double          m_lifted;
     Vec3d           m_pos = Vec3d::Zero();
 
+    uint8_t     _fan_speed_with_offset(uint8_t speed, const Tool *tool) const;
+    std::string _set_fan(uint8_t speed, bool dont_save, const Tool *tool);
     std::string _travel_to_z(double z, const std::string &comment);
     std::string _retract(double length, double restart_extra, double restart_extra_toolchange, const std::string &comment);
 
@@ -21,12 +21,16 @@
 #include <float.h>
 
 #include <algorithm>
+#include <array>
 #include <limits>
+#include <mutex>
 #include <unordered_set>
 #include <boost/filesystem/path.hpp>
 #include <boost/format.hpp>
 #include <boost/log/trivial.hpp>
 
+#include <tbb/parallel_for.h>
+
 // Mark string for localization and translate.
 #define L(s) Slic3r::I18N::translate(s)
 
@@ -61,13 +65,10 @@ PrintRegion* Print::add_region(const PrintRegionConfig &config)
     return m_regions.back();
 }
 
-// Called by Print::apply().
-// This method only accepts PrintConfig option keys.
-bool Print::invalidate_state_by_config_options(const std::vector<t_config_option_key> &opt_keys)
+// Collect the steps of the Print and of its PrintObjects, which are invalidated by a change of opt_key.
+// Returns false if the option is not handled, then all the steps have to be invalidated.
+bool Print::steps_invalidated_by_config_option(const t_config_option_key &opt_key, std::vector<PrintStep> &steps, std::vector<PrintObjectStep> &osteps) const
 {
-    if (opt_keys.empty())
-        return false;
-
     // Cache the plenty of parameters, which influence the G-code generator only,
     // or they are only notes not influencing the generated G-code.
     static std::unordered_set<std::string> steps_gcode = {
@@ -191,128 +192,140 @@ bool Print::invalidate_state_by_config_options(const std::vector<t_config_option
 
     static std::unordered_set<std::string> steps_ignore;
 
+    if (steps_gcode.find(opt_key) != steps_gcode.end()) {
+        // These options only affect G-code export or they are just notes without influence on the generated G-code,
+        // so there is nothing to invalidate.
+        steps.emplace_back(psGCodeExport);
+    } else if (steps_ignore.find(opt_key) != steps_ignore.end()) {
+        // These steps have no influence on the G-code whatsoever. Just ignore them.
+    } else if (
+           opt_key == "skirts"
+        || opt_key == "skirt_height"
+        || opt_key == "draft_shield"
+        || opt_key == "skirt_brim"
+        || opt_key == "skirt_distance"
+        || opt_key == "skirt_distance_from_brim"
+        || opt_key == "min_skirt_length"
+        || opt_key == "complete_objects_one_skirt"
+        || opt_key == "complete_objects_one_brim"
+        || opt_key == "ooze_prevention"
+        || opt_key == "wipe_tower_x"
+        || opt_key == "wipe_tower_y"
+        || opt_key == "wipe_tower_rotation_angle") {
+        steps.emplace_back(psSkirt);
+    } else if (
+        opt_key == "complete_objects") {
+        steps.emplace_back(psBrim);
+        steps.emplace_back(psSkirt);
+        steps.emplace_back(psWipeTower);
+    } else if (
+        opt_key == "brim_inside_holes"
+        || opt_key == "brim_width"
+        || opt_key == "brim_width_interior"
+        || opt_key == "brim_offset"
+        || opt_key == "brim_ears"
+        || opt_key == "brim_ears_detection_length"
+        || opt_key == "brim_ears_max_angle"
+        || opt_key == "brim_ears_pattern") {
+        steps.emplace_back(psBrim);
+        steps.emplace_back(psSkirt);
+    } else if (
+           opt_key == "nozzle_diameter"
+        || opt_key == "resolution"
+        || opt_key == "filament_shrink"
+        // Spiral Vase forces different kind of slicing than the normal model:
+        // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
+        // Therefore toggling the Spiral Vase on / off requires complete reslicing.
+        || opt_key == "spiral_vase"
+        || opt_key == "z_step") {
+        osteps.emplace_back(posSlice);
+    } else if (
+           opt_key == "filament_type"
+        || opt_key == "filament_soluble"
+        || opt_key == "first_layer_temperature"
+        || opt_key == "filament_loading_speed"
+        || opt_key == "filament_loading_speed_start"
+        || opt_key == "filament_unloading_speed"
+        || opt_key == "filament_unloading_speed_start"
+        || opt_key == "filament_toolchange_delay"
+        || opt_key == "filament_cooling_moves"
+        || opt_key == "filament_minimal_purge_on_wipe_tower"
+        || opt_key == "filament_cooling_initial_speed"
+        || opt_key == "filament_cooling_final_speed"
+        || opt_key == "filament_ramming_parameters"
+        || opt_key == "filament_max_speed"
+        || opt_key == "filament_max_volumetric_speed"
+        || opt_key == "filament_use_skinnydip"        // skinnydip params start
+        || opt_key == "filament_use_fast_skinnydip"
+        || opt_key == "filament_skinnydip_distance"
+        || opt_key == "filament_melt_zone_pause"
+        || opt_key == "filament_cooling_zone_pause"
+        || opt_key == "filament_toolchange_temp"
+        || opt_key == "filament_enable_toolchange_temp"
+        || opt_key == "filament_enable_toolchange_part_fan"
+        || opt_key == "filament_toolchange_part_fan_speed"
+        || opt_key == "filament_dip_insertion_speed"
+        || opt_key == "filament_dip_extraction_speed"    //skinnydip params end	
+        || opt_key == "gcode_flavor"
+        || opt_key == "high_current_on_filament_swap"
+        || opt_key == "infill_first"
+        || opt_key == "single_extruder_multi_material"
+        || opt_key == "temperature"
+        || opt_key == "wipe_tower"
+        || opt_key == "wipe_tower_width"
+        || opt_key == "wipe_tower_bridging"
+        || opt_key == "wipe_tower_no_sparse_layers"
+        || opt_key == "wiping_volumes_matrix"
+        || opt_key == "parking_pos_retraction"
+        || opt_key == "cooling_tube_retraction"
+        || opt_key == "cooling_tube_length"
+        || opt_key == "extra_loading_move"
+        || opt_key == "z_offset"
+        || opt_key == "wipe_tower_brim") {
+        steps.emplace_back(psWipeTower);
+        steps.emplace_back(psSkirt);
+    }
+    else if (
+        opt_key == "first_layer_extrusion_width"
+        || opt_key == "min_layer_height"
+        || opt_key == "max_layer_height"
+        || opt_key == "filament_max_overlap") {
+        osteps.emplace_back(posPerimeters);
+        osteps.emplace_back(posInfill);
+        osteps.emplace_back(posSupportMaterial);
+        steps.emplace_back(psSkirt);
+        steps.emplace_back(psBrim);
+    }
+    else if (opt_key == "posSlice")
+        osteps.emplace_back(posSlice);
+    else if (opt_key == "posPerimeters")
+        osteps.emplace_back(posPerimeters);
+    else if (opt_key == "posPrepareInfill")
+        osteps.emplace_back(posPrepareInfill);
+    else if (opt_key == "posInfill")
+        osteps.emplace_back(posInfill);
+    else if (opt_key == "posSupportMaterial")
+        osteps.emplace_back(posSupportMaterial);
+    else if (opt_key == "posCount")
+        osteps.emplace_back(posCount);
+    else
+        return false;
+    return true;
+}
+
+// Called by Print::apply().
+// This method only accepts PrintConfig option keys.
+bool Print::invalidate_state_by_config_options(const std::vector<t_config_option_key> &opt_keys)
+{
+    if (opt_keys.empty())
+        return false;
+
     std::vector<PrintStep> steps;
     std::vector<PrintObjectStep> osteps;
     bool invalidated = false;
 
     for (const t_config_option_key &opt_key : opt_keys) {
-        if (steps_gcode.find(opt_key) != steps_gcode.end()) {
-            // These options only affect G-code export or they are just notes without influence on the generated G-code,
-            // so there is nothing to invalidate.
-            steps.emplace_back(psGCodeExport);
-        } else if (steps_ignore.find(opt_key) != steps_ignore.end()) {
-            // These steps have no influence on the G-code whatsoever. Just ignore them.
-        } else if (
-               opt_key == "skirts"
-            || opt_key == "skirt_height"
-            || opt_key == "draft_shield"
-            || opt_key == "skirt_brim"
-            || opt_key == "skirt_distance"
-            || opt_key == "skirt_distance_from_brim"
-            || opt_key == "min_skirt_length"
-            || opt_key == "complete_objects_one_skirt"
-            || opt_key == "complete_objects_one_brim"
-            || opt_key == "ooze_prevention"
-            || opt_key == "wipe_tower_x"
-            || opt_key == "wipe_tower_y"
-            || opt_key == "wipe_tower_rotation_angle") {
-            steps.emplace_back(psSkirt);
-        } else if (
-            opt_key == "complete_objects") {
-            steps.emplace_back(psBrim);
-            steps.emplace_back(psSkirt);
-            steps.emplace_back(psWipeTower);
-        } else if (
-            opt_key == "brim_inside_holes"
-            || opt_key == "brim_width"
-            || opt_key == "brim_width_interior"
-            || opt_key == "brim_offset"
-            || opt_key == "brim_ears"
-            || opt_key == "brim_ears_detection_length"
-            || opt_key == "brim_ears_max_angle"
-            || opt_key == "brim_ears_pattern") {
-            steps.emplace_back(psBrim);
-            steps.emplace_back(psSkirt);
-        } else if (
-               opt_key == "nozzle_diameter"
-            || opt_key == "resolution"
-            || opt_key == "filament_shrink"
-            // Spiral Vase forces different kind of slicing than the normal model:
-            // In Spiral Vase mode, holes are closed and only the largest area contour is kept at each layer.
-            // Therefore toggling the Spiral Vase on / off requires complete reslicing.
-            || opt_key == "spiral_vase"
-            || opt_key == "z_step") {
-            osteps.emplace_back(posSlice);
-        } else if (
-               opt_key == "filament_type"
-            || opt_key == "filament_soluble"
-            || opt_key == "first_layer_temperature"
-            || opt_key == "filament_loading_speed"
-            || opt_key == "filament_loading_speed_start"
-            || opt_key == "filament_unloading_speed"
-            || opt_key == "filament_unloading_speed_start"
-            || opt_key == "filament_toolchange_delay"
-            || opt_key == "filament_cooling_moves"
-            || opt_key == "filament_minimal_purge_on_wipe_tower"
-            || opt_key == "filament_cooling_initial_speed"
-            || opt_key == "filament_cooling_final_speed"
-            || opt_key == "filament_ramming_parameters"
-            || opt_key == "filament_max_speed"
-            || opt_key == "filament_max_volumetric_speed"
-            || opt_key == "filament_use_skinnydip"        // skinnydip params start
-            || opt_key == "filament_use_fast_skinnydip"
-            || opt_key == "filament_skinnydip_distance"
-            || opt_key == "filament_melt_zone_pause"
-            || opt_key == "filament_cooling_zone_pause"
-            || opt_key == "filament_toolchange_temp"
-            || opt_key == "filament_enable_toolchange_temp"
-            || opt_key == "filament_enable_toolchange_part_fan"
-            || opt_key == "filament_toolchange_part_fan_speed"
-            || opt_key == "filament_dip_insertion_speed"
-            || opt_key == "filament_dip_extraction_speed"    //skinnydip params end	
-            || opt_key == "gcode_flavor"
-            || opt_key == "high_current_on_filament_swap"
-            || opt_key == "infill_first"
-            || opt_key == "single_extruder_multi_material"
-            || opt_key == "temperature"
-            || opt_key == "wipe_tower"
-            || opt_key == "wipe_tower_width"
-            || opt_key == "wipe_tower_bridging"
-            || opt_key == "wipe_tower_no_sparse_layers"
-            || opt_key == "wiping_volumes_matrix"
-            || opt_key == "parking_pos_retraction"
-            || opt_key == "cooling_tube_retraction"
-            || opt_key == "cooling_tube_length"
-            || opt_key == "extra_loading_move"
-            || opt_key == "z_offset"
-            || opt_key == "wipe_tower_brim") {
-            steps.emplace_back(psWipeTower);
-            steps.emplace_back(psSkirt);
-        }
-        else if (
-            opt_key == "first_layer_extrusion_width"
-            || opt_key == "min_layer_height"
-            || opt_key == "max_layer_height"
-            || opt_key == "filament_max_overlap") {
-            osteps.emplace_back(posPerimeters);
-            osteps.emplace_back(posInfill);
-            osteps.emplace_back(posSupportMaterial);
-            steps.emplace_back(psSkirt);
-            steps.emplace_back(psBrim);
-        }
-        else if (opt_key == "posSlice")
-            osteps.emplace_back(posSlice);
-        else if (opt_key == "posPerimeters")
-            osteps.emplace_back(posPerimeters);
-        else if (opt_key == "posPrepareInfill")
-            osteps.emplace_back(posPrepareInfill);
-        else if (opt_key == "posInfill")
-            osteps.emplace_back(posInfill);
-        else if (opt_key == "posSupportMaterial")
-            osteps.emplace_back(posSupportMaterial);
-        else if (opt_key == "posCount")
-            osteps.emplace_back(posCount);
-        else {
+        if (! this->steps_invalidated_by_config_option(opt_key, steps, osteps)) {
             // for legacy, if we can't handle this option let's invalidate all steps
             //FIXME invalidate all steps of all objects as well?
             invalidated |= this->invalidate_all_steps();
@@ -1799,17 +1812,64 @@ void Print::process()
     name_tbb_thread_pool_threads();
     bool something_done = !is_step_done_unguarded(psBrim);
     BOOST_LOG_TRIVIAL(info) << "Starting the slicing process." << log_memory_info();
-    for (PrintObject *obj : m_objects)
-        obj->make_perimeters();
-    this->set_status(70, L("Infilling layers"));
-    //note: as object seems to be sliced independantly, it's maybe possible to add a tbb parallel_loop with simple partitioner on infill,
-    //  as prepare_infill has some function not // 
-    for (PrintObject *obj : m_objects)
-        obj->infill();
-    for (PrintObject *obj : m_objects)
-        obj->ironing();
-    for (PrintObject *obj : m_objects)
-        obj->generate_support_material();
+    // The objects are processed independently of each other, only the steps of a single object depend on each other.
+    // Run the step chain of each object as its own task, so that the infill of an object may be generated while another
+    // object is still generating its perimeters, instead of waiting at a barrier after each step for the slowest object.
+    // The layer loops inside the steps stay parallel, TBB balances the nested tasks over the worker threads.
+    // The first exception thrown (CanceledException included) cancels the other tasks and is rethrown here.
+    const size_t        nb_objects_to_slice = std::count_if(m_objects.begin(), m_objects.end(),
+        [](const PrintObject *obj) { return ! obj->is_step_done(posSlice); });
+    if (nb_objects_to_slice > 0)
+        this->set_status(10, L("Processing triangulated mesh"));
+    // If several objects are processed concurrently, their statuses would interleave and the progress would jump back and forth.
+    // Then the objects don't report their steps, the progress is reported for the whole plate instead: the number of the object steps
+    // done, scaled into the progress band of the object steps (from 10 to the 85 of "Generating support material").
+    m_plate_progress = m_objects.size() > 1;
+    enum PlateStep { plsSlice, plsPerimeters, plsInfill, plsSupportMaterial, plsCount };
+    std::mutex                    plate_progress_mutex;
+    size_t                        nb_steps_done = 0;
+    std::array<size_t, plsCount>  nb_objects_done {};
+    auto plate_step_done = [this, &plate_progress_mutex, &nb_steps_done, &nb_objects_done](PlateStep step) {
+        // The status is reported under the lock, so that it never decreases.
+        std::lock_guard<std::mutex> lock(plate_progress_mutex);
+        std::vector<std::string> args { std::to_string(++ nb_objects_done[step]), std::to_string(m_objects.size()) };
+        int percent = 10 + int((++ nb_steps_done * 75) / (plsCount * m_objects.size()));
+        switch (step) {
+        case plsSlice:           this->set_status(percent, L("Slicing object %s / %s"), args); break;
+        case plsPerimeters:      this->set_status(percent, L("Generating perimeters of object %s / %s"), args); break;
+        case plsInfill:          this->set_status(percent, L("Infilling object %s / %s"), args); break;
+        case plsSupportMaterial: this->set_status(percent, L("Generating support material of object %s / %s"), args); break;
+        default: assert(false);
+        }
+    };
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, m_objects.size(), 1),
+        [this, &plate_step_done](const tbb::blocked_range<size_t> &range) {
+            for (size_t idx_object = range.begin(); idx_object < range.end(); ++ idx_object) {
+                PrintObject *obj = m_objects[idx_object];
+                obj->load_state();
+                if (! obj->is_step_done(posSlice)) {
+                    obj->slice();
+                    if (! m_plate_progress)
+                        this->set_status(20, L("Slicing object %s / %s"), { "1", "1" });
+                }
+                if (m_plate_progress)
+                    plate_step_done(plsSlice);
+                obj->make_perimeters();
+                if (m_plate_progress)
+                    plate_step_done(plsPerimeters);
+                else
+                    this->set_status(70, L("Infilling layers"));
+                obj->infill();
+                obj->ironing();
+                if (m_plate_progress)
+                    plate_step_done(plsInfill);
+                obj->generate_support_material();
+                if (m_plate_progress)
+                    plate_step_done(plsSupportMaterial);
+                obj->store_state();
+            }
+        });
+    this->throw_if_canceled();
     if (this->set_started(psWipeTower)) {
         m_wipe_tower_data.clear();
         m_tool_ordering.clear();
@@ -2361,8 +2421,8 @@ void Print::_make_brim(const Flow &flow, const PrintObjectPtrs &objects, ExPolyg
     this->throw_if_canceled();
 
     //don't collide with objects
-    brimmable_areas = diff_ex(brimmable_areas, unbrimmable_areas, true);
-    brimmable_areas = diff_ex(brimmable_areas, unbrimmable, true);
+    brimmable_areas = diff_ex_clipped(brimmable_areas, unbrimmable_areas, true);
+    brimmable_areas = diff_ex_clipped(brimmable_areas, unbrimmable, true);
 
     this->throw_if_canceled();
 
@@ -24,6 +24,7 @@ class ModelObject;
 class GCode;
 enum class SlicingMode : uint32_t;
 class Layer;
+class SliceCache;
 class SupportLayer;
 
 namespace FillAdaptive {
@@ -212,7 +213,7 @@ protected:
     friend class Print;
 
 	PrintObject(Print* print, ModelObject* model_object, const Transform3d& trafo, PrintInstances&& instances);
-	~PrintObject() = default;
+	~PrintObject();
 
     void                    config_apply(const ConfigBase &other, bool ignore_nonexistent = false) { this->m_config.apply(other, ignore_nonexistent); }
     void                    config_apply_only(const ConfigBase &other, const t_config_option_keys &keys, bool ignore_nonexistent = false) { this->m_config.apply_only(other, keys, ignore_nonexistent); }
@@ -223,6 +224,8 @@ protected:
     bool                    invalidate_all_steps();
     // Invalidate steps based on a set of parameters changed.
     bool                    invalidate_state_by_config_options(const std::vector<t_config_option_key> &opt_keys);
+    // Collect the PrintObject and Print steps invalidated by a change of opt_key. Returns false if opt_key is not handled.
+    bool                    steps_invalidated_by_config_option(const t_config_option_key &opt_key, std::vector<PrintObjectStep> &steps, std::vector<PrintStep> &print_steps) const;
     // If ! m_slicing_params.valid, recalculate.
     void                    update_slicing_parameters();
 
@@ -237,6 +240,16 @@ private:
     void generate_support_material();
 
     void _slice(const std::vector<coordf_t> &layer_height_profile);
+    // Create the layers for the layer_height_profile, returns their slicing Z coordinates.
+    std::vector<float> _make_layers(const std::vector<coordf_t> &layer_height_profile);
+    // Key of the slices of this object in the Print's SliceCache, hashing the meshes and the configuration values the slicing depends on.
+    std::string _slice_cache_key(const std::vector<coordf_t> &layer_height_profile) const;
+    bool _load_slices(const SliceCache &cache, const std::string &key, const std::vector<coordf_t> &layer_height_profile);
+    void _store_slices(const SliceCache &cache, const std::string &key) const;
+    // Load the state after posSupportMaterial from the Print's SliceCache, marking the steps up to posSupportMaterial as done.
+    // Returns false if there is no such entry, then the key is kept to store the state once computed by store_state().
+    bool load_state();
+    void store_state();
     ExPolygons _shrink_contour_holes(double contour_delta, double default_delta, double convex_delta, const ExPolygons& input) const;
     ExPolygons _grow_contour_holes(double contour_delta, double default_delta, double convex_delta, const ExPolygons& input) const;
     void _transform_hole_to_polyholes();
@@ -244,7 +257,9 @@ private:
     std::string _fix_slicing_errors();
     void simplify_slices(coord_t distance);
     bool has_support_material() const;
+    template<typename LayerType> static void delete_layers(std::vector<LayerType*> &layers);
     void detect_surfaces_type();
+    void detect_surfaces_type_layer(size_t idx_region, size_t idx_layer, Surfaces &surfaces_out);
     void process_external_surfaces();
     void discover_vertical_shells();
     void bridge_over_infill();
@@ -280,6 +295,12 @@ private:
     // this is set to true when LayerRegion->slices is split in top/internal/bottom
     // so that next call to make_perimeters() performs a union() before computing loops
     bool                                    m_typed_slices = false;
+    // Set by make_perimeters() if it already classified the slices and prepared the fill surfaces of each layer
+    // right after its perimeters, so that the next prepare_infill() skips these passes.
+    bool                                    m_fill_surfaces_prepared = false;
+
+    // Key of the state to be stored into the Print's SliceCache after posSupportMaterial, see load_state().
+    std::string                             m_state_cache_key;
 
     std::vector<ExPolygons> slice_region(size_t region_id, const std::vector<float> &z, SlicingMode mode, size_t slicing_mode_normal_below_layer, SlicingMode mode_below) const;
     std::vector<ExPolygons> slice_region(size_t region_id, const std::vector<float> &z, SlicingMode mode) const
@@ -475,6 +496,10 @@ public:
     // It does NOT encompass MMU/MMU2 starting (wipe) areas.
     const Polygon&                   first_layer_convex_hull() const { return m_first_layer_convex_hull; }
 
+    // On-disk cache of the sliced objects, shared by the prints slicing the same parts. No cache is used if not set.
+    void                        set_slice_cache(std::shared_ptr<const SliceCache> slice_cache) { m_slice_cache = std::move(slice_cache); }
+    const SliceCache*           slice_cache() const { return m_slice_cache.get(); }
+
     const PrintStatistics&      print_statistics() const { return m_print_statistics; }
     PrintStatistics&            print_statistics() { return m_print_statistics; }
 
@@ -499,6 +524,8 @@ protected:
 
     // Invalidates the step, and its depending steps in Print.
     bool                invalidate_step(PrintStep step);
+    // Collect the Print and PrintObject steps invalidated by a change of opt_key. Returns false if opt_key is not handled.
+    bool                steps_invalidated_by_config_option(const t_config_option_key &opt_key, std::vector<PrintStep> &steps, std::vector<PrintObjectStep> &osteps) const;
 
 private:
 	void 				config_diffs(
@@ -549,6 +576,12 @@ private:
     // Estimated print time, filament consumed.
     PrintStatistics                         m_print_statistics;
 
+    std::shared_ptr<const SliceCache>       m_slice_cache;
+
+    // Set by process() if it processes several PrintObjects concurrently. Then process() reports the progress of the whole plate
+    // and the PrintObjects don't report the progress of their steps, otherwise the progress bar would jump between their values.
+    bool                                    m_plate_progress { false };
+
     // To allow GCode to set the Print's GCodeExport step status.
     friend class GCode;
     // Allow PrintObject to access m_mutex and m_cancel_callback.
@@ -6946,6 +6946,13 @@ CLIActionsConfigDef::CLIActionsConfigDef()
     def->set_default_value(new ConfigOptionBool(false));
 */
 
+    def = this->add("batch", coBool);
+    def->label = L("Batch slicing");
+    def->tooltip = L("Keep running and slice the jobs read from the standard input, one job per line, until the end of the input or a \"quit\" line. "
+                     "Each job is written with the command line syntax: the input files, --output, --load, --center, --duplicate, --dont-arrange "
+                     "and the print options, which are applied over the configuration given on the command line.");
+    def->set_default_value(new ConfigOptionBool(false));
+
     def = this->add("export_sla", coBool);
     def->label = L("Export SLA");
     def->tooltip = L("Slice the model and export SLA printing layers as PNG.");
@@ -7135,6 +7142,18 @@ CLIMiscConfigDef::CLIMiscConfigDef()
     def->tooltip = L("The file where the output will be written (if not specified, it will be based on the input file).");
     def->cli = "output|o";
 
+    def = this->add("batch_jobs", coInt);
+    def->label = L("Batch jobs");
+    def->tooltip = L("Number of jobs sliced concurrently with --batch.");
+    def->min = 1;
+    def->set_default_value(new ConfigOptionInt(1));
+
+    def = this->add("slice_cache", coString);
+    def->label = L("Slice cache directory");
+    def->tooltip = L("Directory of a cache of the sliced objects. An object sliced again with the same mesh and the same slicing settings "
+                     "is loaded from the cache instead of being sliced. The directory may be shared by several concurrent processes.");
+    def->set_default_value(new ConfigOptionString());
+
     def = this->add("single_instance", coBool);
     def->label = L("Single instance mode");
     def->tooltip = L("If enabled, the command line arguments are sent to an existing instance of GUI Slic3r, "
@@ -8,6 +8,7 @@
 #include "Layer.hpp"
 #include "SupportMaterial.hpp"
 #include "Surface.hpp"
+#include "SliceCache.hpp"
 #include "Slicing.hpp"
 #include "Tesselate.hpp"
 #include "Utils.hpp"
@@ -78,6 +79,12 @@ namespace Slic3r {
         m_config.parent = &print->config();
     }
 
+    PrintObject::~PrintObject()
+    {
+        this->clear_layers();
+        this->clear_support_layers();
+    }
+
     PrintBase::ApplyStatus PrintObject::set_instances(PrintInstances&& instances)
     {
         for (PrintInstance& i : instances)
@@ -112,24 +119,33 @@ namespace Slic3r {
     {
         if (!this->set_started(posSlice))
             return;
-        m_print->set_status(10, L("Processing triangulated mesh"));
+        // The status is reported by Print::process() for all the objects sliced concurrently.
         std::vector<coordf_t> layer_height_profile;
         this->update_layer_height_profile(*this->model_object(), m_slicing_params, layer_height_profile);
         m_print->throw_if_canceled();
-        this->_slice(layer_height_profile);
-        m_print->throw_if_canceled();
-        // Fix the model.
-        //FIXME is this the right place to do? It is done repeateadly at the UI and now here at the backend.
-        std::string warning = this->_fix_slicing_errors();
-        m_print->throw_if_canceled();
-        if (!warning.empty())
-            BOOST_LOG_TRIVIAL(info) << warning;
-        // Simplify slices if required.
-        if (m_print->config().resolution.value > 0)
-            this->simplify_slices(scale_(this->print()->config().resolution.value));
-
-        //create polyholes
-        this->_transform_hole_to_polyholes();
+        const SliceCache *slice_cache = m_print->slice_cache();
+        std::string       slice_cache_key;
+        if (slice_cache != nullptr)
+            slice_cache_key = this->_slice_cache_key(layer_height_profile);
+        if (slice_cache == nullptr || ! this->_load_slices(*slice_cache, slice_cache_key, layer_height_profile)) {
+            this->_slice(layer_height_profile);
+            m_print->throw_if_canceled();
+            // Fix the model.
+            //FIXME is this the right place to do? It is done repeateadly at the UI and now here at the backend.
+            std::string warning = this->_fix_slicing_errors();
+            m_print->throw_if_canceled();
+            if (!warning.empty())
+                BOOST_LOG_TRIVIAL(info) << warning;
+            // Simplify slices if required.
+            if (m_print->config().resolution.value > 0)
+                this->simplify_slices(scale_(this->print()->config().resolution.value));
+
+            //create polyholes
+            this->_transform_hole_to_polyholes();
+            m_print->throw_if_canceled();
+            if (slice_cache != nullptr && ! m_layers.empty())
+                this->_store_slices(*slice_cache, slice_cache_key);
+        }
 
         // Update bounding boxes, back up raw slices of complex models.
         tbb::parallel_for(
@@ -302,7 +318,8 @@ namespace Slic3r {
         if (!this->set_started(posPerimeters))
             return;
 
-        m_print->set_status(20, L("Generating perimeters"));
+        if (! m_print->m_plate_progress)
+            m_print->set_status(20, L("Generating perimeters"));
         BOOST_LOG_TRIVIAL(info) << "Generating perimeters..." << log_memory_info();
 
         // Revert the typed slices into untyped slices.
@@ -313,6 +330,17 @@ namespace Slic3r {
             }
             m_typed_slices = false;
         }
+        m_fill_surfaces_prepared = false;
+
+        // Without interface shells, detect_surfaces_type() of a layer reads just the lslices of its neighbors, which are final
+        // after posSlice, and the perimeters of the layer itself. Thus a layer is classified and its fill surfaces are prepared
+        // in the same task right after its perimeters, instead of waiting for the perimeters of all the layers.
+        // The spiral vase modifies the surface types over a range of layers, and the milling post-process expects untyped slices.
+        const bool prepare_fill_surfaces = ! this->print()->config().spiral_vase.value && ! m_config.interface_shells.value &&
+            this->print()->config().milling_diameter.empty();
+        if (prepare_fill_surfaces)
+            // Set before any layer gets typed, so that a canceled run is reverted by the next call.
+            m_typed_slices = true;
 
         // atomic counter for gui progress
         std::atomic<int> atomic_count{ 0 };
@@ -392,17 +420,27 @@ namespace Slic3r {
         BOOST_LOG_TRIVIAL(debug) << "Generating perimeters in parallel - start";
         tbb::parallel_for(
             tbb::blocked_range<size_t>(0, m_layers.size()),
-            [this, &atomic_count, &last_update, nb_layers_update](const tbb::blocked_range<size_t>& range) {
+            [this, &atomic_count, &last_update, nb_layers_update, prepare_fill_surfaces](const tbb::blocked_range<size_t>& range) {
             for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx) {
                 std::chrono::time_point<std::chrono::system_clock> start_make_perimeter = std::chrono::system_clock::now();
                 m_print->throw_if_canceled();
                 m_layers[layer_idx]->make_perimeters();
+                if (prepare_fill_surfaces) {
+                    // Same as detect_surfaces_type() followed by prepare_fill_surfaces() in prepare_infill(), for this layer only.
+                    for (size_t region_id = 0; region_id < this->region_volumes.size(); ++region_id) {
+                        LayerRegion* layerm = m_layers[layer_idx]->m_regions[region_id];
+                        this->detect_surfaces_type_layer(region_id, layer_idx, layerm->m_slices.surfaces);
+                        layerm->slices_to_fill_surfaces_clipped();
+                    }
+                    for (LayerRegion* layerm : m_layers[layer_idx]->m_regions)
+                        layerm->prepare_fill_surfaces();
+                }
 
                 // updating progress
                 int nb_layers_done = (++atomic_count);
                 std::chrono::time_point<std::chrono::system_clock> end_make_perimeter = std::chrono::system_clock::now();
                 if (nb_layers_done % nb_layers_update == 0 || (static_cast<std::chrono::duration<double>>(end_make_perimeter - start_make_perimeter)).count() > 5) {
-                    if ((static_cast<std::chrono::duration<double>>(end_make_perimeter - last_update)).count() > 0.2) {
+                    if (! m_print->m_plate_progress && (static_cast<std::chrono::duration<double>>(end_make_perimeter - last_update)).count() > 0.2) {
                         // note: i don't care if a thread erase last_update in-between here
                         last_update = std::chrono::system_clock::now();
                         m_print->set_status( int((nb_layers_done * 100) / m_layers.size()), L("Generating perimeters: layer %s / %s"), { std::to_string(nb_layers_done), std::to_string(m_layers.size()) });
@@ -429,6 +467,7 @@ namespace Slic3r {
             BOOST_LOG_TRIVIAL(debug) << "Generating milling post-process in parallel - end";
         }
 
+        m_fill_surfaces_prepared = prepare_fill_surfaces;
         this->set_done(posPerimeters);
     }
 
@@ -437,24 +476,30 @@ namespace Slic3r {
         if (!this->set_started(posPrepareInfill))
             return;
 
-        m_print->set_status(30, L("Preparing infill"));
+        if (! m_print->m_plate_progress)
+            m_print->set_status(30, L("Preparing infill"));
 
         // This will assign a type (top/bottom/internal) to $layerm->slices.
         // Then the classifcation of $layerm->slices is transfered onto 
         // the $layerm->fill_surfaces by clipping $layerm->fill_surfaces
         // by the cummulative area of the previous $layerm->fill_surfaces.
-        this->detect_surfaces_type();
-        m_print->throw_if_canceled();
+        // Both passes may have been done already by make_perimeters(), layer by layer.
+        if (! m_fill_surfaces_prepared) {
+            this->detect_surfaces_type();
+            m_print->throw_if_canceled();
 
-        // Decide what surfaces are to be filled.
-        // Here the stTop / stBottomBridge / stBottom infill is turned to just stInternal if zero top / bottom infill layers are configured.
-        // Also tiny stInternal surfaces are turned to stInternalSolid.
-        BOOST_LOG_TRIVIAL(info) << "Preparing fill surfaces..." << log_memory_info();
-        for (auto* layer : m_layers)
-            for (auto* region : layer->m_regions) {
-                region->prepare_fill_surfaces();
-                m_print->throw_if_canceled();
-            }
+            // Decide what surfaces are to be filled.
+            // Here the stTop / stBottomBridge / stBottom infill is turned to just stInternal if zero top / bottom infill layers are configured.
+            // Also tiny stInternal surfaces are turned to stInternalSolid.
+            BOOST_LOG_TRIVIAL(info) << "Preparing fill surfaces..." << log_memory_info();
+            for (auto* layer : m_layers)
+                for (auto* region : layer->m_regions) {
+                    region->prepare_fill_surfaces();
+                    m_print->throw_if_canceled();
+                }
+        }
+        // The following passes modify the fill surfaces, a rerun of this step has to start from the slices again.
+        m_fill_surfaces_prepared = false;
 
         // this will detect bridges and reverse bridges
         // and rearrange top/bottom/internal surfaces
@@ -596,7 +641,7 @@ namespace Slic3r {
                     int nb_layers_done = (++atomic_count);
                     std::chrono::time_point<std::chrono::system_clock> end_make_fill = std::chrono::system_clock::now();
                     if (nb_layers_done % nb_layers_update == 0 || (static_cast<std::chrono::duration<double>>(end_make_fill - start_make_fill)).count() > 5) {
-                        if ((static_cast<std::chrono::duration<double>>(end_make_fill - last_update)).count() > 0.2) {
+                        if (! m_print->m_plate_progress && (static_cast<std::chrono::duration<double>>(end_make_fill - last_update)).count() > 0.2) {
                             // note: i don't care if a thread erase last_update in-between here
                             last_update = std::chrono::system_clock::now();
                             m_print->set_status( int((nb_layers_done * 100) / m_layers.size()), L("Infilling layer %s / %s"), { std::to_string(nb_layers_done), std::to_string(m_layers.size()) });
@@ -642,7 +687,8 @@ namespace Slic3r {
         if (this->set_started(posSupportMaterial)) {
             this->clear_support_layers();
             if ((m_config.support_material || m_config.raft_layers > 0) && m_layers.size() > 1) {
-                m_print->set_status(85, L("Generating support material"));
+                if (! m_print->m_plate_progress)
+                    m_print->set_status(85, L("Generating support material"));
                 this->_generate_support_material();
                 m_print->throw_if_canceled();
             } else {
@@ -699,11 +745,23 @@ namespace Slic3r {
             support_line_spacing ? build_octree(mesh, overhangs.front(), support_line_spacing, true) : OctreePtr());
     }
 
+    // A layer owns a lot of small heap blocks (points of the slices, surfaces and extrusions), freeing all the layers
+    // of a large object takes a while. The layers don't reference each other's data, delete them in parallel.
+    template<typename LayerType>
+    void PrintObject::delete_layers(std::vector<LayerType*> &layers)
+    {
+        tbb::parallel_for(
+            tbb::blocked_range<size_t>(0, layers.size()),
+            [&layers](const tbb::blocked_range<size_t>& range) {
+                for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++layer_idx)
+                    delete layers[layer_idx];
+            });
+        layers.clear();
+    }
+
     void PrintObject::clear_layers()
     {
-        for (Layer* l : m_layers)
-            delete l;
-        m_layers.clear();
+        delete_layers(m_layers);
     }
 
     Layer* PrintObject::add_layer(int id, coordf_t height, coordf_t print_z, coordf_t slice_z)
@@ -714,9 +772,7 @@ namespace Slic3r {
 
     void PrintObject::clear_support_layers()
     {
-        for (Layer* l : m_support_layers)
-            delete l;
-        m_support_layers.clear();
+        delete_layers(m_support_layers);
     }
 
     SupportLayer* PrintObject::add_support_layer(int id, coordf_t height, coordf_t print_z)
@@ -730,6 +786,212 @@ namespace Slic3r {
         return m_support_layers.insert(pos, new SupportLayer(id, this, height, print_z, slice_z));
     }
 
+    // Collect the steps of this PrintObject and of the Print, which are invalidated by a change of opt_key.
+    // Returns false if the option is not handled, then all the steps have to be invalidated.
+    bool PrintObject::steps_invalidated_by_config_option(const t_config_option_key& opt_key, std::vector<PrintObjectStep>& steps, std::vector<PrintStep>& print_steps) const
+    {
+        if (
+            opt_key == "gap_fill"
+            || opt_key == "gap_fill_last"
+            || opt_key == "gap_fill_min_area"
+            || opt_key == "only_one_perimeter_first_layer"
+            || opt_key == "only_one_perimeter_top"
+            || opt_key == "only_one_perimeter_top_other_algo"
+            || opt_key == "overhangs_width_speed"
+            || opt_key == "overhangs_width"
+            || opt_key == "overhangs_reverse"
+            || opt_key == "overhangs_reverse_threshold"
+            || opt_key == "perimeter_extrusion_spacing"
+            || opt_key == "perimeter_extrusion_width"
+            || opt_key == "infill_overlap"
+            || opt_key == "thin_perimeters"
+            || opt_key == "thin_perimeters_all"
+            || opt_key == "thin_walls"
+            || opt_key == "thin_walls_min_width"
+            || opt_key == "thin_walls_overlap"
+            || opt_key == "external_perimeters_first"
+            || opt_key == "external_perimeters_hole"
+            || opt_key == "external_perimeters_nothole"
+            || opt_key == "external_perimeter_extrusion_spacing"
+            || opt_key == "external_perimeter_extrusion_width"
+            || opt_key == "external_perimeters_vase"
+            || opt_key == "perimeter_loop"
+            || opt_key == "perimeter_loop_seam") {
+            steps.emplace_back(posPerimeters);
+        } else if (
+            opt_key == "layer_height"
+            || opt_key == "first_layer_height"
+            || opt_key == "exact_last_layer_height"
+            || opt_key == "raft_layers"
+            || opt_key == "slice_closing_radius"
+            || opt_key == "clip_multipart_objects"
+            || opt_key == "first_layer_size_compensation"
+            || opt_key == "first_layer_size_compensation_layers"
+            || opt_key == "elephant_foot_min_width"
+            || opt_key == "dont_support_bridges"
+            || opt_key == "support_material_contact_distance_type"
+            || opt_key == "support_material_contact_distance_top"
+            || opt_key == "support_material_contact_distance_bottom"
+            || opt_key == "xy_size_compensation"
+            || opt_key == "hole_size_compensation"
+            || opt_key == "hole_size_threshold"
+            || opt_key == "hole_to_polyhole"
+            || opt_key == "hole_to_polyhole_threshold") {
+            steps.emplace_back(posSlice);
+        } else if (opt_key == "support_material") {
+            steps.emplace_back(posSupportMaterial);
+            if (m_config.support_material_contact_distance_top.value == 0. || m_config.support_material_contact_distance_bottom.value == 0.) {
+                // Enabling / disabling supports while soluble support interface is enabled.
+                // This changes the bridging logic (bridging enabled without supports, disabled with supports).
+                // Reset everything.
+                // See GH #1482 for details.
+                steps.emplace_back(posSlice);
+            }
+        } else if (
+            opt_key == "support_material_auto"
+            || opt_key == "support_material_angle"
+            || opt_key == "support_material_buildplate_only"
+            || opt_key == "support_material_enforce_layers"
+            || opt_key == "support_material_extruder"
+            || opt_key == "support_material_extrusion_width"
+            || opt_key == "support_material_interface_layers"
+            || opt_key == "support_material_interface_contact_loops"
+            || opt_key == "support_material_interface_extruder"
+            || opt_key == "support_material_interface_spacing"
+            || opt_key == "support_material_pattern"
+            || opt_key == "support_material_interface_pattern"
+            || opt_key == "support_material_xy_spacing"
+            || opt_key == "support_material_spacing"
+            || opt_key == "support_material_synchronize_layers"
+            || opt_key == "support_material_threshold"
+            || opt_key == "support_material_with_sheath"
+            || opt_key == "support_material_solid_first_layer") {
+            steps.emplace_back(posSupportMaterial);
+        } else if (opt_key == "bottom_solid_layers") {
+            steps.emplace_back(posPrepareInfill);
+            if (m_print->config().spiral_vase
+            || opt_key == "z_step") {
+                // Changing the number of bottom layers when a spiral vase is enabled requires re-slicing the object again.
+                // Otherwise, holes in the bottom layers could be filled, as is reported in GH #5528.
+                steps.emplace_back(posSlice);
+            }
+        } else if (
+            opt_key == "bottom_solid_min_thickness"
+            || opt_key == "ensure_vertical_shell_thickness"
+            || opt_key == "fill_density"
+            || opt_key == "interface_shells"
+            || opt_key == "infill_extruder"
+            || opt_key == "infill_extrusion_spacing"
+            || opt_key == "infill_extrusion_width"
+            || opt_key == "infill_every_layers"
+            || opt_key == "infill_dense"
+            || opt_key == "infill_dense_algo"
+            || opt_key == "infill_not_connected"
+            || opt_key == "infill_only_where_needed"
+            || opt_key == "ironing_type"
+            || opt_key == "solid_infill_below_area"
+            || opt_key == "solid_infill_extruder"
+            || opt_key == "solid_infill_every_layers"
+            || opt_key == "solid_over_perimeters"
+            || opt_key == "top_solid_layers"
+            || opt_key == "top_solid_min_thickness") {
+            steps.emplace_back(posPrepareInfill);
+        } else if (
+            opt_key == "top_fill_pattern"
+            || opt_key == "bottom_fill_pattern"
+            || opt_key == "solid_fill_pattern"
+            || opt_key == "enforce_full_fill_volume"
+            || opt_key == "fill_angle"
+            || opt_key == "fill_angle_increment"
+            || opt_key == "fill_pattern"
+            || opt_key == "fill_top_flow_ratio"
+            || opt_key == "fill_smooth_width"
+            || opt_key == "fill_smooth_distribution"
+            || opt_key == "infill_anchor"
+            || opt_key == "infill_anchor_max"
+            || opt_key == "infill_connection"
+            || opt_key == "infill_connection_solid"
+            || opt_key == "infill_connection_top"
+            || opt_key == "infill_connection_bottom"
+            || opt_key == "seam_gap"
+            || opt_key == "top_infill_extrusion_spacing"
+            || opt_key == "top_infill_extrusion_width" ) {
+            steps.emplace_back(posInfill);
+        } else if (
+            opt_key == "bridge_angle"
+            || opt_key == "bridged_infill_margin"
+            || opt_key == "extra_perimeters"
+            || opt_key == "extra_perimeters_odd_layers"
+            || opt_key == "external_infill_margin"
+            || opt_key == "external_perimeter_overlap"
+            || opt_key == "gap_fill_overlap"
+            || opt_key == "no_perimeter_unsupported_algo"
+            || opt_key == "filament_max_overlap"
+            || opt_key == "perimeters"
+            || opt_key == "perimeter_overlap"
+            || opt_key == "solid_infill_extrusion_spacing"
+            || opt_key == "solid_infill_extrusion_width") {
+            steps.emplace_back(posPerimeters);
+            steps.emplace_back(posPrepareInfill);
+        } else if (
+            opt_key == "external_perimeter_extrusion_width"
+            || opt_key == "perimeter_extruder") {
+            steps.emplace_back(posPerimeters);
+            steps.emplace_back(posSupportMaterial);
+        } else if (opt_key == "bridge_flow_ratio"
+            || opt_key == "first_layer_extrusion_spacing"
+            || opt_key == "first_layer_extrusion_width") {
+            //if (m_config.support_material_contact_distance > 0.) {
+                // Only invalidate due to bridging if bridging is enabled.
+                // If later "support_material_contact_distance" is modified, the complete PrintObject is invalidated anyway.
+            steps.emplace_back(posPerimeters);
+            steps.emplace_back(posInfill);
+            steps.emplace_back(posSupportMaterial);
+            //}
+        } else if (
+            opt_key == "bridge_speed"
+            || opt_key == "bridge_speed_internal"
+            || opt_key == "external_perimeter_speed"
+            || opt_key == "external_perimeters_vase"
+            || opt_key == "gap_fill_speed"
+            || opt_key == "infill_speed"
+            || opt_key == "overhangs_speed"
+            || opt_key == "perimeter_speed"
+            || opt_key == "seam_position"
+            || opt_key == "seam_preferred_direction"
+            || opt_key == "seam_preferred_direction_jitter"
+            || opt_key == "seam_angle_cost"
+            || opt_key == "seam_travel_cost"
+            || opt_key == "small_perimeter_speed"
+            || opt_key == "small_perimeter_min_length"
+            || opt_key == "small_perimeter_max_length"
+            || opt_key == "solid_infill_speed"
+            || opt_key == "support_material_interface_speed"
+            || opt_key == "support_material_speed"
+            || opt_key == "thin_walls_speed"
+            || opt_key == "top_solid_infill_speed") {
+            print_steps.emplace_back(psGCodeExport);
+        } else if (
+            opt_key == "wipe_into_infill"
+            || opt_key == "wipe_into_objects") {
+            print_steps.emplace_back(psWipeTower);
+            print_steps.emplace_back(psGCodeExport);
+        } else if (
+            opt_key == "brim_inside_holes"
+            || opt_key == "brim_width"
+            || opt_key == "brim_width_interior"
+            || opt_key == "brim_offset"
+            || opt_key == "brim_ears"
+            || opt_key == "brim_ears_detection_length"
+            || opt_key == "brim_ears_max_angle"
+            || opt_key == "brim_ears_pattern") {
+            print_steps.emplace_back(psBrim);
+        } else {
+            return false;
+        }
+        return true;
+    }
+
     // Called by Print::apply().
     // This method only accepts PrintObjectConfig and PrintRegionConfig option keys.
     bool PrintObject::invalidate_state_by_config_options(const std::vector<t_config_option_key>& opt_keys)
@@ -738,211 +1000,19 @@ namespace Slic3r {
             return false;
 
         std::vector<PrintObjectStep> steps;
+        std::vector<PrintStep>       print_steps;
         bool invalidated = false;
         for (const t_config_option_key& opt_key : opt_keys) {
-            if (
-                opt_key == "gap_fill"
-                || opt_key == "gap_fill_last"
-                || opt_key == "gap_fill_min_area"
-                || opt_key == "only_one_perimeter_first_layer"
-                || opt_key == "only_one_perimeter_top"
-                || opt_key == "only_one_perimeter_top_other_algo"
-                || opt_key == "overhangs_width_speed"
-                || opt_key == "overhangs_width"
-                || opt_key == "overhangs_reverse"
-                || opt_key == "overhangs_reverse_threshold"
-                || opt_key == "perimeter_extrusion_spacing"
-                || opt_key == "perimeter_extrusion_width"
-                || opt_key == "infill_overlap"
-                || opt_key == "thin_perimeters"
-                || opt_key == "thin_perimeters_all"
-                || opt_key == "thin_walls"
-                || opt_key == "thin_walls_min_width"
-                || opt_key == "thin_walls_overlap"
-                || opt_key == "external_perimeters_first"
-                || opt_key == "external_perimeters_hole"
-                || opt_key == "external_perimeters_nothole"
-                || opt_key == "external_perimeter_extrusion_spacing"
-                || opt_key == "external_perimeter_extrusion_width"
-                || opt_key == "external_perimeters_vase"
-                || opt_key == "perimeter_loop"
-                || opt_key == "perimeter_loop_seam") {
-                steps.emplace_back(posPerimeters);
-            } else if (
-                opt_key == "layer_height"
-                || opt_key == "first_layer_height"
-                || opt_key == "exact_last_layer_height"
-                || opt_key == "raft_layers"
-                || opt_key == "slice_closing_radius"
-                || opt_key == "clip_multipart_objects"
-                || opt_key == "first_layer_size_compensation"
-                || opt_key == "first_layer_size_compensation_layers"
-                || opt_key == "elephant_foot_min_width"
-                || opt_key == "dont_support_bridges"
-                || opt_key == "support_material_contact_distance_type"
-                || opt_key == "support_material_contact_distance_top"
-                || opt_key == "support_material_contact_distance_bottom"
-                || opt_key == "xy_size_compensation"
-                || opt_key == "hole_size_compensation"
-                || opt_key == "hole_size_threshold"
-                || opt_key == "hole_to_polyhole"
-                || opt_key == "hole_to_polyhole_threshold") {
-                steps.emplace_back(posSlice);
-            } else if (opt_key == "support_material") {
-                steps.emplace_back(posSupportMaterial);
-                if (m_config.support_material_contact_distance_top.value == 0. || m_config.support_material_contact_distance_bottom.value == 0.) {
-                    // Enabling / disabling supports while soluble support interface is enabled.
-                    // This changes the bridging logic (bridging enabled without supports, disabled with supports).
-                    // Reset everything.
-                    // See GH #1482 for details.
-                    steps.emplace_back(posSlice);
-                }
-            } else if (
-                opt_key == "support_material_auto"
-                || opt_key == "support_material_angle"
-                || opt_key == "support_material_buildplate_only"
-                || opt_key == "support_material_enforce_layers"
-                || opt_key == "support_material_extruder"
-                || opt_key == "support_material_extrusion_width"
-                || opt_key == "support_material_interface_layers"
-                || opt_key == "support_material_interface_contact_loops"
-                || opt_key == "support_material_interface_extruder"
-                || opt_key == "support_material_interface_spacing"
-                || opt_key == "support_material_pattern"
-                || opt_key == "support_material_interface_pattern"
-                || opt_key == "support_material_xy_spacing"
-                || opt_key == "support_material_spacing"
-                || opt_key == "support_material_synchronize_layers"
-                || opt_key == "support_material_threshold"
-                || opt_key == "support_material_with_sheath"
-                || opt_key == "support_material_solid_first_layer") {
-                steps.emplace_back(posSupportMaterial);
-            } else if (opt_key == "bottom_solid_layers") {
-                steps.emplace_back(posPrepareInfill);
-                if (m_print->config().spiral_vase
-                || opt_key == "z_step") {
-                    // Changing the number of bottom layers when a spiral vase is enabled requires re-slicing the object again.
-                    // Otherwise, holes in the bottom layers could be filled, as is reported in GH #5528.
-                    steps.emplace_back(posSlice);
-                }
-            } else if (
-                opt_key == "bottom_solid_min_thickness"
-                || opt_key == "ensure_vertical_shell_thickness"
-                || opt_key == "fill_density"
-                || opt_key == "interface_shells"
-                || opt_key == "infill_extruder"
-                || opt_key == "infill_extrusion_spacing"
-                || opt_key == "infill_extrusion_width"
-                || opt_key == "infill_every_layers"
-                || opt_key == "infill_dense"
-                || opt_key == "infill_dense_algo"
-                || opt_key == "infill_not_connected"
-                || opt_key == "infill_only_where_needed"
-                || opt_key == "ironing_type"
-                || opt_key == "solid_infill_below_area"
-                || opt_key == "solid_infill_extruder"
-                || opt_key == "solid_infill_every_layers"
-                || opt_key == "solid_over_perimeters"
-                || opt_key == "top_solid_layers"
-                || opt_key == "top_solid_min_thickness") {
-                steps.emplace_back(posPrepareInfill);
-            } else if (
-                opt_key == "top_fill_pattern"
-                || opt_key == "bottom_fill_pattern"
-                || opt_key == "solid_fill_pattern"
-                || opt_key == "enforce_full_fill_volume"
-                || opt_key == "fill_angle"
-                || opt_key == "fill_angle_increment"
-                || opt_key == "fill_pattern"
-                || opt_key == "fill_top_flow_ratio"
-                || opt_key == "fill_smooth_width"
-                || opt_key == "fill_smooth_distribution"
-                || opt_key == "infill_anchor"
-                || opt_key == "infill_anchor_max"
-                || opt_key == "infill_connection"
-                || opt_key == "infill_connection_solid"
-                || opt_key == "infill_connection_top"
-                || opt_key == "infill_connection_bottom"
-                || opt_key == "seam_gap"
-                || opt_key == "top_infill_extrusion_spacing"
-                || opt_key == "top_infill_extrusion_width" ) {
-                steps.emplace_back(posInfill);
-            } else if (
-                opt_key == "bridge_angle"
-                || opt_key == "bridged_infill_margin"
-                || opt_key == "extra_perimeters"
-                || opt_key == "extra_perimeters_odd_layers"
-                || opt_key == "external_infill_margin"
-                || opt_key == "external_perimeter_overlap"
-                || opt_key == "gap_fill_overlap"
-                || opt_key == "no_perimeter_unsupported_algo"
-                || opt_key == "filament_max_overlap"
-                || opt_key == "perimeters"
-                || opt_key == "perimeter_overlap"
-                || opt_key == "solid_infill_extrusion_spacing"
-                || opt_key == "solid_infill_extrusion_width") {
-                steps.emplace_back(posPerimeters);
-                steps.emplace_back(posPrepareInfill);
-            } else if (
-                opt_key == "external_perimeter_extrusion_width"
-                || opt_key == "perimeter_extruder") {
-                steps.emplace_back(posPerimeters);
-                steps.emplace_back(posSupportMaterial);
-            } else if (opt_key == "bridge_flow_ratio"
-                || opt_key == "first_layer_extrusion_spacing"
-                || opt_key == "first_layer_extrusion_width") {
-                //if (m_config.support_material_contact_distance > 0.) {
-                    // Only invalidate due to bridging if bridging is enabled.
-                    // If later "support_material_contact_distance" is modified, the complete PrintObject is invalidated anyway.
-                steps.emplace_back(posPerimeters);
-                steps.emplace_back(posInfill);
-                steps.emplace_back(posSupportMaterial);
-                //}
-            } else if (
-                opt_key == "bridge_speed"
-                || opt_key == "bridge_speed_internal"
-                || opt_key == "external_perimeter_speed"
-                || opt_key == "external_perimeters_vase"
-                || opt_key == "gap_fill_speed"
-                || opt_key == "infill_speed"
-                || opt_key == "overhangs_speed"
-                || opt_key == "perimeter_speed"
-                || opt_key == "seam_position"
-                || opt_key == "seam_preferred_direction"
-                || opt_key == "seam_preferred_direction_jitter"
-                || opt_key == "seam_angle_cost"
-                || opt_key == "seam_travel_cost"
-                || opt_key == "small_perimeter_speed"
-                || opt_key == "small_perimeter_min_length"
-                || opt_key == "small_perimeter_max_length"
-                || opt_key == "solid_infill_speed"
-                || opt_key == "support_material_interface_speed"
-                || opt_key == "support_material_speed"
-                || opt_key == "thin_walls_speed"
-                || opt_key == "top_solid_infill_speed") {
-                invalidated |= m_print->invalidate_step(psGCodeExport);
-            } else if (
-                opt_key == "wipe_into_infill"
-                || opt_key == "wipe_into_objects") {
-                invalidated |= m_print->invalidate_step(psWipeTower);
-                invalidated |= m_print->invalidate_step(psGCodeExport);
-            } else if (
-                opt_key == "brim_inside_holes"
-                || opt_key == "brim_width"
-                || opt_key == "brim_width_interior"
-                || opt_key == "brim_offset"
-                || opt_key == "brim_ears"
-                || opt_key == "brim_ears_detection_length"
-                || opt_key == "brim_ears_max_angle"
-                || opt_key == "brim_ears_pattern") {
-                invalidated |= m_print->invalidate_step(psBrim);
-            } else {
+            if (! this->steps_invalidated_by_config_option(opt_key, steps, print_steps)) {
                 // for legacy, if we can't handle this option let's invalidate all steps
                 this->invalidate_all_steps();
                 invalidated = true;
             }
         }
 
+        sort_remove_duplicates(print_steps);
+        for (PrintStep step : print_steps)
+            invalidated |= m_print->invalidate_step(step);
         sort_remove_duplicates(steps);
         for (PrintObjectStep step : steps)
             invalidated |= this->invalidate_step(step);
@@ -953,6 +1023,10 @@ namespace Slic3r {
     {
         bool invalidated = Inherited::invalidate_step(step);
 
+        // The fill surfaces prepared by make_perimeters() may depend on the invalidated configuration.
+        if (step == posSlice || step == posPerimeters || step == posPrepareInfill)
+            m_fill_surfaces_prepared = false;
+
         // propagate to dependent steps
         if (step == posPerimeters) {
             invalidated |= this->invalidate_steps({ posPrepareInfill, posInfill, posIroning });
@@ -986,6 +1060,7 @@ namespace Slic3r {
         bool result = Inherited::invalidate_all_steps() | m_print->invalidate_all_steps();
         // Then reset some of the depending values.
         this->m_slicing_params.valid = false;
+        this->m_fill_surfaces_prepared = false;
         this->region_volumes.clear();
         return result;
     }
@@ -1331,6 +1406,155 @@ namespace Slic3r {
         }
     }
 
+    // Classify the slices of a single layer of a region for detect_surfaces_type() against the layers below and above.
+    // Without interface shells only the lslices of the neighbor layers are accessed, which are not modified by this function,
+    // so surfaces_out may point to the layerm->m_slices.surfaces of the layer itself.
+    void PrintObject::detect_surfaces_type_layer(size_t idx_region, size_t idx_layer, Surfaces &surfaces_out)
+    {
+        bool spiral_vase = this->print()->config().spiral_vase.value;
+        bool interface_shells = !spiral_vase && m_config.interface_shells.value;
+        // If we have raft layers, consider bottom layer as a bridge just like any other bottom surface lying on the void.
+        SurfaceType surface_type_bottom_1st =
+            (m_config.raft_layers.value > 0 && m_config.support_material_contact_distance_type.value != zdNone) ?
+            stPosBottom | stDensSolid | stModBridge : stPosBottom | stDensSolid;
+        // If we have soluble support material, don't bridge. The overhang will be squished against a soluble layer separating
+        // the support from the print.
+        bool has_bridges = !(m_config.support_material.value
+            && m_config.support_material_contact_distance_type.value == zdNone
+            && !m_config.dont_support_bridges);
+        SurfaceType surface_type_bottom_other =
+            has_bridges ? stPosBottom | stDensSolid | stModBridge : stPosBottom | stDensSolid;
+        // BOOST_LOG_TRIVIAL(trace) << "Detecting solid surfaces for region " << idx_region << " and layer " << layer->print_z;
+        Layer* layer = m_layers[idx_layer];
+        LayerRegion* layerm = layer->m_regions[idx_region];
+        // comparison happens against the *full* slices (considering all regions)
+        // unless internal shells are requested
+        Layer* upper_layer = (idx_layer + 1 < this->layer_count()) ? m_layers[idx_layer + 1] : nullptr;
+        Layer* lower_layer = (idx_layer > 0) ? m_layers[idx_layer - 1] : nullptr;
+        // collapse very narrow parts (using the safety offset in the diff is not enough)
+        float        offset = layerm->flow(frExternalPerimeter).scaled_width() / 10.f;
+
+        Polygons     layerm_slices_surfaces = to_polygons(layerm->slices().surfaces);
+        // no_perimeter_full_bridge allow to put bridges where there are nothing, hence adding area to slice, that's why we need to start from the result of PerimeterGenerator.
+        if (layerm->region()->config().no_perimeter_unsupported_algo.value == npuaFilled) {
+            layerm_slices_surfaces = union_(layerm_slices_surfaces, to_polygons(layerm->fill_surfaces));
+        }
+
+        // find top surfaces (difference between current surfaces
+        // of current layer and upper one)
+        Surfaces top;
+        if (upper_layer) {
+            Polygons upper_slices = interface_shells ?
+                to_polygons(upper_layer->get_region(idx_region)->slices().surfaces) :
+                to_polygons(upper_layer->lslices);
+            surfaces_append(top,
+                //FIXME implement offset2_ex working over ExPolygons, that should be a bit more efficient than calling offset_ex twice.
+                offset_ex(offset_ex(diff_ex(layerm_slices_surfaces, upper_slices, true), -offset), offset),
+                stPosTop | stDensSolid);
+        } else {
+            // if no upper layer, all surfaces of this one are solid
+            // we clone surfaces because we're going to clear the slices collection
+            top = layerm->m_slices.surfaces;
+            for (Surface& surface : top)
+                surface.surface_type = stPosTop | stDensSolid;
+        }
+
+        // Find bottom surfaces (difference between current surfaces of current layer and lower one).
+        Surfaces bottom;
+        if (lower_layer) {
+#if 0
+            //FIXME Why is this branch failing t\multi.t ?
+            Polygons lower_slices = interface_shells ?
+                to_polygons(lower_layer->get_region(idx_region)->slices.surfaces) :
+                to_polygons(lower_layer->slices);
+            surfaces_append(bottom,
+                offset2_ex(diff(layerm_slices_surfaces, lower_slices, true), -offset, offset),
+                surface_type_bottom_other);
+#else
+            ExPolygons lower_slices = lower_layer->lslices;
+            //if we added new surfaces, we can use them as support
+            /*if (layerm->region()->config().no_perimeter_full_bridge) {
+                lower_slices = union_ex(lower_slices, lower_layer->get_region(idx_region)->fill_surfaces);
+            }*/
+            // Any surface lying on the void is a true bottom bridge (an overhang)
+            surfaces_append(
+                bottom,
+                offset2_ex(
+                    diff(layerm_slices_surfaces, to_polygons(lower_slices), true),
+                    -offset, offset),
+                surface_type_bottom_other);
+            // if user requested internal shells, we need to identify surfaces
+            // lying on other slices not belonging to this region
+            if (interface_shells) {
+                // non-bridging bottom surfaces: any part of this layer lying 
+                // on something else, excluding those lying on our own region
+                surfaces_append(
+                    bottom,
+                    offset2_ex(
+                        diff(
+                            intersection(layerm_slices_surfaces, to_polygons(lower_slices)), // supported
+                            to_polygons(lower_layer->get_region(idx_region)->slices().surfaces),
+                            true),
+                        -offset, offset),
+                    stPosBottom | stDensSolid);
+            }
+#endif
+        } else {
+            // if no lower layer, all surfaces of this one are solid
+            // we clone surfaces because we're going to clear the slices collection
+            bottom = layerm->slices().surfaces;
+            for (Surface& surface : bottom)
+                surface.surface_type = surface_type_bottom_1st;
+        }
+
+        // now, if the object contained a thin membrane, we could have overlapping bottom
+        // and top surfaces; let's do an intersection to discover them and consider them
+        // as bottom surfaces (to allow for bridge detection)
+        if (!top.empty() && !bottom.empty()) {
+            //                Polygons overlapping = intersection(to_polygons(top), to_polygons(bottom));
+            //                Slic3r::debugf "  layer %d contains %d membrane(s)\n", $layerm->layer->id, scalar(@$overlapping)
+            //                    if $Slic3r::debug;
+            Polygons top_polygons = to_polygons(std::move(top));
+            top.clear();
+            surfaces_append(top,
+                diff_ex(top_polygons, to_polygons(bottom), false),
+                stPosTop | stDensSolid);
+        }
+
+#ifdef SLIC3R_DEBUG_SLICE_PROCESSING
+        {
+            static int iRun = 0;
+            std::vector<std::pair<Slic3r::ExPolygons, SVG::ExPolygonAttributes>> expolygons_with_attributes;
+            expolygons_with_attributes.emplace_back(std::make_pair(union_ex(top), SVG::ExPolygonAttributes("green")));
+            expolygons_with_attributes.emplace_back(std::make_pair(union_ex(bottom), SVG::ExPolygonAttributes("brown")));
+            expolygons_with_attributes.emplace_back(std::make_pair(to_expolygons(layerm->slices().surfaces), SVG::ExPolygonAttributes("black")));
+            SVG::export_expolygons(debug_out_path("1_detect_surfaces_type_%d_region%d-layer_%f.svg", iRun++, idx_region, layer->print_z).c_str(), expolygons_with_attributes);
+        }
+#endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
+
+        // save surfaces to layer
+        surfaces_out.clear();
+
+        // find internal surfaces (difference between top/bottom surfaces and others)
+        {
+            Polygons topbottom = to_polygons(top);
+            polygons_append(topbottom, to_polygons(bottom));
+            surfaces_append(surfaces_out,
+                diff_ex(layerm_slices_surfaces, topbottom, false),
+                stPosInternal | stDensSparse);
+        }
+
+        surfaces_append(surfaces_out, std::move(top));
+        surfaces_append(surfaces_out, std::move(bottom));
+
+        //            Slic3r::debugf "  layer %d has %d bottom, %d top and %d internal surfaces\n",
+        //                $layerm->layer->id, scalar(@bottom), scalar(@top), scalar(@internal) if $Slic3r::debug;
+
+#ifdef SLIC3R_DEBUG_SLICE_PROCESSING
+        layerm->export_region_slices_to_svg_debug("detect_surfaces_type-final");
+#endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
+    }
+
     // This function analyzes slices of a region (SurfaceCollection slices).
     // Each region slice (instance of Surface) is analyzed, whether it is supported or whether it is the top surface.
     // Initially all slices are of type stInternal.
@@ -1374,149 +1598,9 @@ namespace Slic3r {
                     // In non-spiral vase mode, go over all layers.
                     m_layers.size()),
                 [this, idx_region, interface_shells, &surfaces_new](const tbb::blocked_range<size_t>& range) {
-                // If we have raft layers, consider bottom layer as a bridge just like any other bottom surface lying on the void.
-                SurfaceType surface_type_bottom_1st =
-                    (m_config.raft_layers.value > 0 && m_config.support_material_contact_distance_type.value != zdNone) ?
-                    stPosBottom | stDensSolid | stModBridge : stPosBottom | stDensSolid;
-                // If we have soluble support material, don't bridge. The overhang will be squished against a soluble layer separating
-                // the support from the print.
-                bool has_bridges = !(m_config.support_material.value
-                    && m_config.support_material_contact_distance_type.value == zdNone
-                    && !m_config.dont_support_bridges);
-                SurfaceType surface_type_bottom_other =
-                    has_bridges ? stPosBottom | stDensSolid | stModBridge : stPosBottom | stDensSolid;
                 for (size_t idx_layer = range.begin(); idx_layer < range.end(); ++idx_layer) {
                     m_print->throw_if_canceled();
-                    // BOOST_LOG_TRIVIAL(trace) << "Detecting solid surfaces for region " << idx_region << " and layer " << layer->print_z;
-                    Layer* layer = m_layers[idx_layer];
-                    LayerRegion* layerm = layer->m_regions[idx_region];
-                    // comparison happens against the *full* slices (considering all regions)
-                    // unless internal shells are requested
-                    Layer* upper_layer = (idx_layer + 1 < this->layer_count()) ? m_layers[idx_layer + 1] : nullptr;
-                    Layer* lower_layer = (idx_layer > 0) ? m_layers[idx_layer - 1] : nullptr;
-                    // collapse very narrow parts (using the safety offset in the diff is not enough)
-                    float        offset = layerm->flow(frExternalPerimeter).scaled_width() / 10.f;
-
-                    Polygons     layerm_slices_surfaces = to_polygons(layerm->slices().surfaces);
-                    // no_perimeter_full_bridge allow to put bridges where there are nothing, hence adding area to slice, that's why we need to start from the result of PerimeterGenerator.
-                    if (layerm->region()->config().no_perimeter_unsupported_algo.value == npuaFilled) {
-                        layerm_slices_surfaces = union_(layerm_slices_surfaces, to_polygons(layerm->fill_surfaces));
-                    }
-
-                    // find top surfaces (difference between current surfaces
-                    // of current layer and upper one)
-                    Surfaces top;
-                    if (upper_layer) {
-                        Polygons upper_slices = interface_shells ?
-                            to_polygons(upper_layer->get_region(idx_region)->slices().surfaces) :
-                            to_polygons(upper_layer->lslices);
-                        surfaces_append(top,
-                            //FIXME implement offset2_ex working over ExPolygons, that should be a bit more efficient than calling offset_ex twice.
-                            offset_ex(offset_ex(diff_ex(layerm_slices_surfaces, upper_slices, true), -offset), offset),
-                            stPosTop | stDensSolid);
-                    } else {
-                        // if no upper layer, all surfaces of this one are solid
-                        // we clone surfaces because we're going to clear the slices collection
-                        top = layerm->m_slices.surfaces;
-                        for (Surface& surface : top)
-                            surface.surface_type = stPosTop | stDensSolid;
-                    }
-
-                    // Find bottom surfaces (difference between current surfaces of current layer and lower one).
-                    Surfaces bottom;
-                    if (lower_layer) {
-#if 0
-                        //FIXME Why is this branch failing t\multi.t ?
-                        Polygons lower_slices = interface_shells ?
-                            to_polygons(lower_layer->get_region(idx_region)->slices.surfaces) :
-                            to_polygons(lower_layer->slices);
-                        surfaces_append(bottom,
-                            offset2_ex(diff(layerm_slices_surfaces, lower_slices, true), -offset, offset),
-                            surface_type_bottom_other);
-#else
-                        ExPolygons lower_slices = lower_layer->lslices;
-                        //if we added new surfaces, we can use them as support
-                        /*if (layerm->region()->config().no_perimeter_full_bridge) {
-                            lower_slices = union_ex(lower_slices, lower_layer->get_region(idx_region)->fill_surfaces);
-                        }*/
-                        // Any surface lying on the void is a true bottom bridge (an overhang)
-                        surfaces_append(
-                            bottom,
-                            offset2_ex(
-                                diff(layerm_slices_surfaces, to_polygons(lower_slices), true),
-                                -offset, offset),
-                            surface_type_bottom_other);
-                        // if user requested internal shells, we need to identify surfaces
-                        // lying on other slices not belonging to this region
-                        if (interface_shells) {
-                            // non-bridging bottom surfaces: any part of this layer lying 
-                            // on something else, excluding those lying on our own region
-                            surfaces_append(
-                                bottom,
-                                offset2_ex(
-                                    diff(
-                                        intersection(layerm_slices_surfaces, to_polygons(lower_slices)), // supported
-                                        to_polygons(lower_layer->get_region(idx_region)->slices().surfaces),
-                                        true),
-                                    -offset, offset),
-                                stPosBottom | stDensSolid);
-                        }
-#endif
-                    } else {
-                        // if no lower layer, all surfaces of this one are solid
-                        // we clone surfaces because we're going to clear the slices collection
-                        bottom = layerm->slices().surfaces;
-                        for (Surface& surface : bottom)
-                            surface.surface_type = surface_type_bottom_1st;
-                    }
-
-                    // now, if the object contained a thin membrane, we could have overlapping bottom
-                    // and top surfaces; let's do an intersection to discover them and consider them
-                    // as bottom surfaces (to allow for bridge detection)
-                    if (!top.empty() && !bottom.empty()) {
-                        //                Polygons overlapping = intersection(to_polygons(top), to_polygons(bottom));
-                        //                Slic3r::debugf "  layer %d contains %d membrane(s)\n", $layerm->layer->id, scalar(@$overlapping)
-                        //                    if $Slic3r::debug;
-                        Polygons top_polygons = to_polygons(std::move(top));
-                        top.clear();
-                        surfaces_append(top,
-                            diff_ex(top_polygons, to_polygons(bottom), false),
-                            stPosTop | stDensSolid);
-                    }
-
-#ifdef SLIC3R_DEBUG_SLICE_PROCESSING
-                    {
-                        static int iRun = 0;
-                        std::vector<std::pair<Slic3r::ExPolygons, SVG::ExPolygonAttributes>> expolygons_with_attributes;
-                        expolygons_with_attributes.emplace_back(std::make_pair(union_ex(top), SVG::ExPolygonAttributes("green")));
-                        expolygons_with_attributes.emplace_back(std::make_pair(union_ex(bottom), SVG::ExPolygonAttributes("brown")));
-                        expolygons_with_attributes.emplace_back(std::make_pair(to_expolygons(layerm->slices().surfaces), SVG::ExPolygonAttributes("black")));
-                        SVG::export_expolygons(debug_out_path("1_detect_surfaces_type_%d_region%d-layer_%f.svg", iRun++, idx_region, layer->print_z).c_str(), expolygons_with_attributes);
-                    }
-#endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
-
-                    // save surfaces to layer
-                    Surfaces& surfaces_out = interface_shells ? surfaces_new[idx_layer] : layerm->m_slices.surfaces;
-                    surfaces_out.clear();
-
-                    // find internal surfaces (difference between top/bottom surfaces and others)
-                    {
-                        Polygons topbottom = to_polygons(top);
-                        polygons_append(topbottom, to_polygons(bottom));
-                        surfaces_append(surfaces_out,
-                            diff_ex(layerm_slices_surfaces, topbottom, false),
-                            stPosInternal | stDensSparse);
-                    }
-
-                    surfaces_append(surfaces_out, std::move(top));
-                    surfaces_append(surfaces_out, std::move(bottom));
-
-                    //            Slic3r::debugf "  layer %d has %d bottom, %d top and %d internal surfaces\n",
-                    //                $layerm->layer->id, scalar(@bottom), scalar(@top), scalar(@internal) if $Slic3r::debug;
-
-#ifdef SLIC3R_DEBUG_SLICE_PROCESSING
-                    layerm->export_region_slices_to_svg_debug("detect_surfaces_type-final");
-#endif /* SLIC3R_DEBUG_SLICE_PROCESSING */
+                    this->detect_surfaces_type_layer(idx_region, idx_layer, interface_shells ? surfaces_new[idx_layer] : m_layers[idx_layer]->m_regions[idx_region]->m_slices.surfaces);
                 }
             }
             ); // for each layer of a region
@@ -2499,31 +2583,7 @@ namespace Slic3r {
         m_typed_slices = false;
 
         // 1) Initialize layers and their slice heights.
-        std::vector<float> slice_zs;
-        {
-            this->clear_layers();
-            // Object layers (pairs of bottom/top Z coordinate), without the raft.
-            std::vector<coordf_t> object_layers = generate_object_layers(m_slicing_params, layer_height_profile);
-            // Reserve object layers for the raft. Last layer of the raft is the contact layer.
-            int id = int(m_slicing_params.raft_layers());
-            slice_zs.reserve(object_layers.size());
-            Layer* prev = nullptr;
-            for (size_t i_layer = 0; i_layer < object_layers.size(); i_layer += 2) {
-                coordf_t lo = object_layers[i_layer];
-                coordf_t hi = object_layers[i_layer + 1];
-                coordf_t slice_z = 0.5 * (lo + hi);
-                Layer* layer = this->add_layer(id++, hi - lo, hi + m_slicing_params.object_print_z_min, slice_z);
-                slice_zs.push_back(float(slice_z));
-                if (prev != nullptr) {
-                    prev->upper_layer = layer;
-                    layer->lower_layer = prev;
-                }
-                // Make sure all layers contain layer region objects for all regions.
-                for (size_t region_id = 0; region_id < this->region_volumes.size(); ++region_id)
-                    layer->add_region(this->print()->regions()[region_id]);
-                prev = layer;
-            }
-        }
+        std::vector<float> slice_zs = this->_make_layers(layer_height_profile);
 
         // Count model parts and modifier meshes, check whether the model parts are of the same region.
         int              all_volumes_single_region = -2; // not set yet
@@ -2882,6 +2942,335 @@ namespace Slic3r {
         BOOST_LOG_TRIVIAL(debug) << "Slicing objects - make_slices in parallel - end";
     }
 
+    std::vector<float> PrintObject::_make_layers(const std::vector<coordf_t>& layer_height_profile)
+    {
+        std::vector<float> slice_zs;
+        this->clear_layers();
+        // Object layers (pairs of bottom/top Z coordinate), without the raft.
+        std::vector<coordf_t> object_layers = generate_object_layers(m_slicing_params, layer_height_profile);
+        // Reserve object layers for the raft. Last layer of the raft is the contact layer.
+        int id = int(m_slicing_params.raft_layers());
+        slice_zs.reserve(object_layers.size());
+        Layer* prev = nullptr;
+        for (size_t i_layer = 0; i_layer < object_layers.size(); i_layer += 2) {
+            coordf_t lo = object_layers[i_layer];
+            coordf_t hi = object_layers[i_layer + 1];
+            coordf_t slice_z = 0.5 * (lo + hi);
+            Layer* layer = this->add_layer(id++, hi - lo, hi + m_slicing_params.object_print_z_min, slice_z);
+            slice_zs.push_back(float(slice_z));
+            if (prev != nullptr) {
+                prev->upper_layer = layer;
+                layer->lower_layer = prev;
+            }
+            // Make sure all layers contain layer region objects for all regions.
+            for (size_t region_id = 0; region_id < this->region_volumes.size(); ++region_id)
+                layer->add_region(this->print()->regions()[region_id]);
+            prev = layer;
+        }
+        return slice_zs;
+    }
+
+    // Version of the slice cache entries, to be increased whenever the slicing or the serialization changes its output.
+    static constexpr const uint32_t SLICE_CACHE_VERSION = 1;
+
+    std::string PrintObject::_slice_cache_key(const std::vector<coordf_t>& layer_height_profile) const
+    {
+        SliceCache::Hasher hasher;
+        hasher.add(SLICE_CACHE_VERSION);
+        hasher.add(std::string(SLIC3R_VERSION_FULL));
+
+        // Layers.
+        hasher.add(generate_object_layers(m_slicing_params, layer_height_profile));
+        hasher.add(m_slicing_params.object_print_z_min);
+        hasher.add(uint32_t(m_slicing_params.raft_layers()));
+
+        // Meshes, as they are placed by slice_volume() and slice_volumes().
+        for (size_t i = 0; i < 16; ++ i)
+            hasher.add(m_trafo.data()[i]);
+        hasher.add(m_center_offset.x());
+        hasher.add(m_center_offset.y());
+        for (const ModelVolume* model_volume : this->model_object()->volumes) {
+            hasher.add(uint32_t(model_volume->type()));
+            const Transform3d& matrix = model_volume->get_matrix();
+            for (size_t i = 0; i < 16; ++ i)
+                hasher.add(matrix.data()[i]);
+            const stl_file& stl = model_volume->mesh().stl;
+            hasher.add(uint32_t(stl.facet_start.size()));
+            for (const stl_facet& facet : stl.facet_start)
+                hasher.add(facet.vertex, sizeof(facet.vertex));
+        }
+        for (const std::vector<std::pair<t_layer_height_range, int>>& volumes : this->region_volumes) {
+            hasher.add(uint32_t(volumes.size()));
+            for (const std::pair<t_layer_height_range, int>& volume_and_range : volumes) {
+                hasher.add(volume_and_range.first.first);
+                hasher.add(volume_and_range.first.second);
+                hasher.add(volume_and_range.second);
+            }
+        }
+
+        // Configuration. Only the options invalidating posSlice, or not handled by steps_invalidated_by_config_option() are hashed,
+        // so that for example a change of the infill does not miss the cache.
+        const bool spiral_vase = m_print->config().spiral_vase.value;
+        auto add_config = [this, &hasher, spiral_vase](const ConfigBase& config) {
+            for (const t_config_option_key& opt_key : config.keys()) {
+                std::vector<PrintObjectStep> steps;
+                std::vector<PrintStep>       print_steps;
+                bool hash = ! this->steps_invalidated_by_config_option(opt_key, steps, print_steps) ||
+                    std::find(steps.begin(), steps.end(), posSlice) != steps.end() ||
+                    // Used by the slicing, but not invalidating posSlice: the perimeter extruder selects the filament shrinkage,
+                    // the external perimeter flow is used by the Elephant foot compensation.
+                    opt_key == "perimeter_extruder" ||
+                    opt_key == "external_perimeter_extrusion_width" ||
+                    opt_key == "external_perimeter_extrusion_spacing" ||
+                    opt_key == "first_layer_extrusion_width" ||
+                    opt_key == "first_layer_extrusion_spacing" ||
+                    (spiral_vase && (opt_key == "bottom_solid_layers" || opt_key == "bottom_solid_min_thickness"));
+                if (hash) {
+                    hasher.add(opt_key);
+                    hasher.add(config.opt_serialize(opt_key));
+                }
+            }
+        };
+        add_config(m_config);
+        for (size_t region_id = 0; region_id < this->region_volumes.size(); ++ region_id)
+            add_config(this->print()->regions()[region_id]->config());
+        for (const char* opt_key : { "filament_shrink", "nozzle_diameter", "resolution", "spiral_vase" }) {
+            hasher.add(std::string(opt_key));
+            hasher.add(m_print->config().opt_serialize(opt_key));
+        }
+        return hasher.digest();
+    }
+
+    static std::string slicing_errors_warning()
+    {
+        return "The model has overlapping or self-intersecting facets. I tried to repair it, "
+            "however you might want to check the results or repair the input file and retry.\n";
+    }
+
+    bool PrintObject::_load_slices(const SliceCache& cache, const std::string& key, const std::vector<coordf_t>& layer_height_profile)
+    {
+        std::string data;
+        if (! cache.load(key, data))
+            return false;
+        BOOST_LOG_TRIVIAL(info) << "Loading slices from the slice cache " << key;
+        m_typed_slices = false;
+        this->_make_layers(layer_height_profile);
+        SliceCache::Reader reader(data);
+        // The empty top layers were removed by _slice(), the empty bottom layers by _fix_slicing_errors().
+        size_t   num_layers  = size_t(reader.read<uint32_t>());
+        size_t   num_regions = size_t(reader.read<uint32_t>());
+        coordf_t first_z     = reader.read<coordf_t>();
+        size_t   num_bottom  = 0;
+        while (num_bottom < m_layers.size() && m_layers[num_bottom]->print_z < first_z - EPSILON)
+            ++ num_bottom;
+        bool     ok          = reader.ok() && num_layers > 0 && num_bottom + num_layers <= m_layers.size() && num_regions == this->region_volumes.size();
+        if (ok) {
+            while (m_layers.size() > num_bottom + num_layers) {
+                delete m_layers.back();
+                m_layers.pop_back();
+            }
+            m_layers.back()->upper_layer = nullptr;
+            if (num_bottom > 0) {
+                for (size_t i = 0; i < num_bottom; ++ i)
+                    delete m_layers[i];
+                m_layers.erase(m_layers.begin(), m_layers.begin() + num_bottom);
+                m_layers.front()->lower_layer = nullptr;
+                for (size_t i = 0; i < m_layers.size(); ++ i)
+                    m_layers[i]->set_id(m_layers[i]->id() - num_bottom);
+            }
+            bool slicing_errors = false;
+            for (Layer* layer : m_layers) {
+                layer->slicing_errors = reader.read<bool>();
+                slicing_errors |= layer->slicing_errors;
+                reader.read(layer->lslices);
+                for (LayerRegion* layerm : layer->m_regions)
+                    reader.read(layerm->m_slices.surfaces);
+            }
+            ok = reader.ok() && reader.at_end();
+            if (ok && slicing_errors)
+                // The slices were repaired by _fix_slicing_errors() before being stored.
+                BOOST_LOG_TRIVIAL(info) << slicing_errors_warning();
+        }
+        if (! ok) {
+            BOOST_LOG_TRIVIAL(error) << "Invalid slice cache entry " << key << ", slicing again";
+            this->clear_layers();
+        }
+        return ok;
+    }
+
+    void PrintObject::_store_slices(const SliceCache& cache, const std::string& key) const
+    {
+        SliceCache::Writer writer;
+        writer.write(uint32_t(m_layers.size()));
+        writer.write(uint32_t(this->region_volumes.size()));
+        writer.write(m_layers.front()->print_z);
+        for (const Layer* layer : m_layers) {
+            writer.write(layer->slicing_errors);
+            writer.write(layer->lslices);
+            for (const LayerRegion* layerm : layer->regions())
+                writer.write(layerm->slices().surfaces);
+        }
+        cache.store(key, writer.data());
+    }
+
+    bool PrintObject::load_state()
+    {
+        m_state_cache_key.clear();
+        const SliceCache* cache = m_print->slice_cache();
+        // Only a complete state is cached, thus it is only loaded if all the steps are to be computed.
+        if (cache == nullptr || this->is_step_done(posSlice))
+            return false;
+
+        std::vector<coordf_t> layer_height_profile;
+        this->update_layer_height_profile(*this->model_object(), m_slicing_params, layer_height_profile);
+
+        SliceCache::Hasher hasher;
+        hasher.add(std::string("state"));
+        hasher.add(this->_slice_cache_key(layer_height_profile));
+        // All the object and region options, but only the print options influencing the PrintObject steps,
+        // so that for example the temperatures or the start G-code may be changed without slicing again.
+        auto add_option = [&hasher](const ConfigBase& config, const t_config_option_key& opt_key) {
+            hasher.add(opt_key);
+            hasher.add(config.opt_serialize(opt_key));
+        };
+        for (const t_config_option_key& opt_key : m_config.keys())
+            add_option(m_config, opt_key);
+        for (size_t region_id = 0; region_id < this->region_volumes.size(); ++ region_id)
+            for (const t_config_option_key& opt_key : this->print()->regions()[region_id]->config().keys())
+                add_option(this->print()->regions()[region_id]->config(), opt_key);
+        for (const t_config_option_key& opt_key : m_print->config().keys()) {
+            std::vector<PrintStep>       steps;
+            std::vector<PrintObjectStep> osteps;
+            if (! m_print->steps_invalidated_by_config_option(opt_key, steps, osteps) || ! osteps.empty())
+                add_option(m_print->config(), opt_key);
+        }
+        // Painted supports and seams.
+        for (const ModelVolume* model_volume : this->model_object()->volumes)
+            for (const FacetsAnnotation* facets : { &model_volume->supported_facets, &model_volume->seam_facets }) {
+                hasher.add(uint32_t(facets->get_data().size()));
+                for (const std::pair<const int, std::vector<bool>>& facet : facets->get_data()) {
+                    hasher.add(facet.first);
+                    hasher.add(std::vector<uint8_t>(facet.second.begin(), facet.second.end()));
+                }
+            }
+        std::string key = hasher.digest();
+
+        std::string data;
+        if (! cache->load(key, data)) {
+            m_state_cache_key = std::move(key);
+            return false;
+        }
+        BOOST_LOG_TRIVIAL(info) << "Loading the sliced object from the slice cache " << key;
+        this->clear_layers();
+        this->clear_support_layers();
+        SliceCache::Reader reader(data);
+        size_t num_layers  = size_t(reader.read<uint32_t>());
+        size_t num_regions = size_t(reader.read<uint32_t>());
+        if (num_regions != this->region_volumes.size())
+            num_layers = 0;
+        Layer* prev = nullptr;
+        for (size_t i = 0; i < num_layers && reader.ok(); ++ i) {
+            int      id      = reader.read<int>();
+            coordf_t height  = reader.read<coordf_t>();
+            coordf_t print_z = reader.read<coordf_t>();
+            coordf_t slice_z = reader.read<coordf_t>();
+            Layer*   layer   = this->add_layer(id, height, print_z, slice_z);
+            if (prev != nullptr) {
+                prev->upper_layer = layer;
+                layer->lower_layer = prev;
+            }
+            prev = layer;
+            layer->slicing_errors = reader.read<bool>();
+            reader.read(layer->lslices);
+            layer->lslices_bboxes.reserve(layer->lslices.size());
+            for (const ExPolygon& expoly : layer->lslices)
+                layer->lslices_bboxes.emplace_back(get_extents(expoly));
+            for (size_t region_id = 0; region_id < num_regions; ++ region_id) {
+                LayerRegion* layerm = layer->add_region(this->print()->regions()[region_id]);
+                reader.read(layerm->m_slices.surfaces);
+                reader.read(layerm->raw_slices);
+                reader.read(layerm->thin_fills);
+                reader.read(layerm->fill_expolygons);
+                reader.read(layerm->fill_no_overlap_expolygons);
+                reader.read(layerm->fill_surfaces.surfaces);
+                reader.read(layerm->unsupported_bridge_edges);
+                reader.read(layerm->perimeters);
+                reader.read(layerm->milling);
+                reader.read(layerm->fills);
+                reader.read(layerm->ironings);
+            }
+        }
+        m_typed_slices = reader.read<bool>();
+        size_t num_support_layers = size_t(reader.read<uint32_t>());
+        for (size_t i = 0; i < num_support_layers && reader.ok(); ++ i) {
+            int           id      = reader.read<int>();
+            coordf_t      height  = reader.read<coordf_t>();
+            coordf_t      print_z = reader.read<coordf_t>();
+            SupportLayer* layer   = this->add_support_layer(id, height, print_z);
+            layer->slice_z = reader.read<coordf_t>();
+            reader.read(layer->lslices);
+            reader.read(layer->support_islands.expolygons);
+            reader.read(layer->support_fills);
+        }
+        if (! reader.ok() || ! reader.at_end() || m_layers.empty()) {
+            BOOST_LOG_TRIVIAL(error) << "Invalid slice cache entry " << key << ", slicing again";
+            this->clear_layers();
+            this->clear_support_layers();
+            m_typed_slices = false;
+            m_state_cache_key = std::move(key);
+            return false;
+        }
+        for (int step = posSlice; step <= posSupportMaterial; ++ step) {
+            this->set_started(PrintObjectStep(step));
+            this->set_done(PrintObjectStep(step));
+        }
+        return true;
+    }
+
+    void PrintObject::store_state()
+    {
+        if (m_state_cache_key.empty() || ! this->is_step_done(posSupportMaterial) || m_layers.empty())
+            return;
+        SliceCache::Writer writer;
+        writer.write(uint32_t(m_layers.size()));
+        writer.write(uint32_t(this->region_volumes.size()));
+        for (const Layer* layer : m_layers) {
+            writer.write(int(layer->id()));
+            writer.write(layer->height);
+            writer.write(layer->print_z);
+            writer.write(layer->slice_z);
+            writer.write(layer->slicing_errors);
+            writer.write(layer->lslices);
+            assert(layer->regions().size() == this->region_volumes.size());
+            for (const LayerRegion* layerm : layer->regions()) {
+                writer.write(layerm->slices().surfaces);
+                writer.write(layerm->raw_slices);
+                writer.write(layerm->thin_fills);
+                writer.write(layerm->fill_expolygons);
+                writer.write(layerm->fill_no_overlap_expolygons);
+                writer.write(layerm->fill_surfaces.surfaces);
+                writer.write(layerm->unsupported_bridge_edges);
+                writer.write(layerm->perimeters);
+                writer.write(layerm->milling);
+                writer.write(layerm->fills);
+                writer.write(layerm->ironings);
+            }
+        }
+        writer.write(m_typed_slices);
+        writer.write(uint32_t(m_support_layers.size()));
+        for (const SupportLayer* layer : m_support_layers) {
+            writer.write(int(layer->id()));
+            writer.write(layer->height);
+            writer.write(layer->print_z);
+            writer.write(layer->slice_z);
+            writer.write(layer->lslices);
+            writer.write(layer->support_islands.expolygons);
+            writer.write(layer->support_fills);
+        }
+        m_print->slice_cache()->store(m_state_cache_key, writer.data());
+        m_state_cache_key.clear();
+    }
+
     ExPolygons PrintObject::_shrink_contour_holes(double contour_delta, double not_convex_delta, double convex_delta, const ExPolygons& polys) const {
         ExPolygons new_ex_polys;
         double max_hole_area = scale_d(scale_d(m_config.hole_size_threshold.value));
@@ -3376,9 +3765,7 @@ static void fix_mesh_connectivity(TriangleMesh &mesh)
                 m_layers[i]->set_id(m_layers[i]->id() - 1);
         }
 
-        return buggy_layers.empty() ? "" :
-            "The model has overlapping or self-intersecting facets. I tried to repair it, "
-            "however you might want to check the results or repair the input file and retry.\n";
+        return buggy_layers.empty() ? "" : slicing_errors_warning();
     }
 
     // Simplify the sliced model, if "resolution" configuration parameter > 0.
@@ -36,33 +36,21 @@ template<class Color> struct Colors {
 template<class Color> const Color Colors<Color>::White = Color{255};
 template<class Color> const Color Colors<Color>::Black = Color{0};
 
-template<class PixelRenderer,
-         template<class /*agg::renderer_base<PixelRenderer>*/> class Renderer,
-         class Rasterizer = agg::rasterizer_scanline_aa<>,
-         class Scanline   = agg::scanline_p8>
-class AGGRaster: public RasterBase {
-public:
-    using TColor = typename PixelRenderer::color_type;
-    using TValue = typename TColor::value_type;
-    using TPixel = typename PixelRenderer::pixel_type;
-    using TRawBuffer = agg::rendering_buffer;
-    
+// Converts polygons in scaled coordinates into AGG paths in the pixel space of
+// a raster, applying the raster transformation (orientation and mirroring).
+class AGGPathConverter {
 protected:
+    RasterBase::Resolution m_resolution;
+    RasterBase::PixelDim m_pxdim_scaled;    // used for scaled coordinate polygons
+    RasterBase::Trafo m_trafo;
     
-    Resolution m_resolution;
-    PixelDim m_pxdim_scaled;    // used for scaled coordinate polygons
-    
-    std::vector<TPixel> m_buf;
-    agg::rendering_buffer m_rbuf;
-    
-    PixelRenderer m_pixrenderer;
-    
-    agg::renderer_base<PixelRenderer> m_raw_renderer;
-    Renderer<agg::renderer_base<PixelRenderer>> m_renderer;
-    
-    Trafo m_trafo;
-    Scanline m_scanlines;
-    Rasterizer m_rasterizer;
+    AGGPathConverter(const RasterBase::Resolution &res,
+                     const RasterBase::PixelDim &  pd,
+                     const RasterBase::Trafo &     trafo)
+        : m_resolution(res)
+        , m_pxdim_scaled(SCALING_FACTOR / pd.w_mm, SCALING_FACTOR / pd.h_mm)
+        , m_trafo(trafo)
+    {}
     
     void flipy(agg::path_storage &path) const
     {
@@ -117,13 +105,41 @@ protected:
         return path;
     }
     
+    template<class Rasterizer, class P> void add_paths(Rasterizer &rasterizer, const P &poly)
+    {
+        rasterizer.add_path(to_path(contour(poly)));
+        for(auto& h : holes(poly)) rasterizer.add_path(to_path(h));
+    }
+};
+
+template<class PixelRenderer,
+         template<class /*agg::renderer_base<PixelRenderer>*/> class Renderer,
+         class Rasterizer = agg::rasterizer_scanline_aa<>,
+         class Scanline   = agg::scanline_p8>
+class AGGRaster: public RasterBase, protected AGGPathConverter {
+public:
+    using TColor = typename PixelRenderer::color_type;
+    using TValue = typename TColor::value_type;
+    using TPixel = typename PixelRenderer::pixel_type;
+    using TRawBuffer = agg::rendering_buffer;
+    
+protected:
+    
+    std::vector<TPixel> m_buf;
+    agg::rendering_buffer m_rbuf;
+    
+    PixelRenderer m_pixrenderer;
+    
+    agg::renderer_base<PixelRenderer> m_raw_renderer;
+    Renderer<agg::renderer_base<PixelRenderer>> m_renderer;
+    
+    Scanline m_scanlines;
+    Rasterizer m_rasterizer;
+    
     template<class P> void _draw(const P &poly)
     {
         m_rasterizer.reset();
-        
-        m_rasterizer.add_path(to_path(contour(poly)));
-        for(auto& h : holes(poly)) m_rasterizer.add_path(to_path(h));
-        
+        add_paths(m_rasterizer, poly);
         agg::render_scanlines(m_rasterizer, m_scanlines, m_renderer);
     }
     
@@ -135,8 +151,7 @@ public:
               const TColor &    foreground,
               const TColor &    background,
               GammaFn &&        gammafn)
-        : m_resolution(res)
-        , m_pxdim_scaled(SCALING_FACTOR / pd.w_mm, SCALING_FACTOR / pd.h_mm)
+        : AGGPathConverter(res, pd, trafo)
         , m_buf(res.pixels())
         , m_rbuf(reinterpret_cast<TValue *>(m_buf.data()),
                  unsigned(res.width_px),
@@ -145,7 +160,6 @@ public:
         , m_pixrenderer(m_rbuf)
         , m_raw_renderer(m_pixrenderer)
         , m_renderer(m_raw_renderer)
-        , m_trafo(trafo)
     {
         m_renderer.color(foreground);
         clear(background);
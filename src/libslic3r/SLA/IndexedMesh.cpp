@@ -41,6 +41,15 @@ public:
                                                  s, dir, hits);
     }
 
+    void intersect_rays(const TriangleMesh& tm,
+                        const Vec3d* s, const Vec3d* dirs, size_t n, igl::Hit* hits)
+    {
+        AABBTreeIndirect::intersect_rays_first_hit(tm.its.vertices,
+                                                   tm.its.indices,
+                                                   m_tree,
+                                                   s, dirs, n, hits);
+    }
+
     double squared_distance(const TriangleMesh& tm,
                             const Vec3d& point, int& i, Eigen::Matrix<double, 1, 3>& closest) {
         size_t idx_unsigned = 0;
@@ -173,6 +182,54 @@ IndexedMesh::query_ray_hits(const Vec3d &s, const Vec3d &dir) const
 }
 
 
+std::vector<IndexedMesh::hit_result>
+IndexedMesh::query_rays_hit(const std::vector<Vec3d> &s,
+                            const std::vector<Vec3d> &dirs) const
+{
+    assert(s.size() == dirs.size());
+    std::vector<IndexedMesh::hit_result> outs;
+    outs.reserve(s.size());
+
+#ifdef SLIC3R_HOLE_RAYCASTER
+    if (! m_holes.empty()) {
+        for (size_t i = 0; i < s.size(); ++i)
+            outs.emplace_back(query_ray_hit(s[i], dirs[i]));
+        return outs;
+    }
+#endif
+
+    std::vector<igl::Hit> hits(s.size());
+
+    // A packet of rays is the unit of the parallel work.
+    const size_t packet_size = AABBTreeIndirect::RayPacketSize;
+    const size_t num_packets = (s.size() + packet_size - 1) / packet_size;
+    auto cast_packet = [this, &s, &dirs, &hits, packet_size](size_t packet) {
+        size_t begin = packet * packet_size;
+        m_aabb->intersect_rays(*m_tm, s.data() + begin, dirs.data() + begin,
+                               std::min(packet_size, s.size() - begin),
+                               hits.data() + begin);
+    };
+
+    if (num_packets > 1)
+        ccr::for_each(size_t(0), num_packets, cast_packet);
+    else if (num_packets == 1)
+        cast_packet(0);
+
+    for (size_t i = 0; i < s.size(); ++i) {
+        const igl::Hit &hit = hits[i];
+        outs.emplace_back(IndexedMesh::hit_result(*this));
+        outs.back().m_t = double(hit.t);
+        outs.back().m_dir = dirs[i];
+        outs.back().m_source = s[i];
+        if(!std::isinf(hit.t) && !std::isnan(hit.t)) {
+            outs.back().m_normal = this->normal_by_face_id(hit.id);
+            outs.back().m_face_id = hit.id;
+        }
+    }
+
+    return outs;
+}
+
 #ifdef SLIC3R_HOLE_RAYCASTER
 IndexedMesh::hit_result IndexedMesh::filter_hits(
     const std::vector<IndexedMesh::hit_result>& object_hits) const
@@ -120,6 +120,13 @@ public:
     // Casts a ray on the mesh and returns all hits
     std::vector<hit_result> query_ray_hits(const Vec3d &s, const Vec3d &dir) const;
 
+    // Casts a bunch of rays on the mesh, returns the same as query_ray_hit()
+    // for each of them. The rays are traversed through the AABB tree in
+    // packets, thus coherent rays (sharing a source or a direction) are cast
+    // faster. Multiple packets are cast in parallel.
+    std::vector<hit_result> query_rays_hit(const std::vector<Vec3d> &s,
+                                           const std::vector<Vec3d> &dirs) const;
+
     double squared_distance(const Vec3d& p, int& i, Vec3d& c) const;
     inline double squared_distance(const Vec3d &p) const
     {
@@ -0,0 +1,138 @@
+#include <libslic3r/SLA/RLERaster.hpp>
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+
+namespace Slic3r { namespace sla {
+
+namespace {
+
+// Appends a run to a row, merging it with the last one if they are adjacent
+// and of the same value. Black runs are not stored.
+inline void append_run(RLERasterGrayscaleAA::Row &row, uint32_t x, uint32_t len, uint8_t value)
+{
+    if (len == 0 || value == 0)
+        return;
+
+    if (!row.empty() && row.back().x + row.back().len == x && row.back().value == value)
+        row.back().len += len;
+    else
+        row.push_back({x, len, value});
+}
+
+// Blends the white foreground color with the given coverage over a pixel.
+// The same as agg::pixfmt_gray8::copy_or_blend_pix() does for an opaque color.
+inline uint8_t blend_white(uint8_t px, uint8_t cover)
+{
+    if (cover == agg::cover_full)
+        return agg::gray8::full_value();
+
+    agg::blender_gray8::blend_pix(&px, agg::gray8::full_value(), agg::gray8::full_value(), cover);
+    return px;
+}
+
+} // namespace
+
+void RLERasterGrayscaleAA::blend_scanline(const agg::scanline_p8 &sl)
+{
+    int y = sl.y();
+    if (y < 0 || y >= int(m_resolution.height_px))
+        return;
+
+    // Collect the coverage of the scanline clipped to the raster, like
+    // agg::renderer_base clips the spans. Zero coverage leaves the pixels as
+    // they are, thus it is not stored.
+    const int w = int(m_resolution.width_px);
+    m_covers.clear();
+
+    unsigned num_spans = sl.num_spans();
+    auto     span      = sl.begin();
+    for (;;) {
+        int x = span->x;
+        if (span->len > 0) {
+            for (int i = std::max(0, -x); i < span->len && x + i < w; ++i)
+                append_run(m_covers, uint32_t(x + i), 1, span->covers[i]);
+        } else {
+            // Solid span of -len pixels with a single coverage value.
+            int x1 = std::max(x, 0), x2 = std::min(x - span->len, w);
+            if (x1 < x2)
+                append_run(m_covers, uint32_t(x1), uint32_t(x2 - x1), *span->covers);
+        }
+
+        if (--num_spans == 0) break;
+        ++span;
+    }
+
+    if (m_covers.empty())
+        return;
+
+    // Merge the coverage runs into the runs of the row. Both are sorted and
+    // non-overlapping, so they are swept together, cutting them at the
+    // boundaries of each other.
+    const Row &row = m_rows[size_t(y)];
+    Row        out;
+    out.reserve(row.size() + m_covers.size());
+
+    constexpr uint32_t none = std::numeric_limits<uint32_t>::max();
+
+    size_t   i = 0, j = 0;
+    uint32_t pos = 0;
+    while (i < row.size() || j < m_covers.size()) {
+        const Run *o = i < row.size() ? &row[i] : nullptr;
+        const Run *c = j < m_covers.size() ? &m_covers[j] : nullptr;
+
+        uint32_t o_begin = o ? std::max(o->x, pos) : none, o_end = o ? o->x + o->len : none;
+        uint32_t c_begin = c ? std::max(c->x, pos) : none, c_end = c ? c->x + c->len : none;
+
+        uint32_t begin = std::min(o_begin, c_begin);
+        bool     in_o  = o_begin == begin;
+        bool     in_c  = c_begin == begin;
+        uint32_t end   = std::min(in_o ? o_end : o_begin, in_c ? c_end : c_begin);
+
+        uint8_t px = in_o ? o->value : uint8_t(0);
+        append_run(out, begin, end - begin, in_c ? blend_white(px, c->value) : px);
+
+        pos = end;
+        if (o && o_end <= pos) ++i;
+        if (c && c_end <= pos) ++j;
+    }
+
+    m_rows[size_t(y)] = std::move(out);
+}
+
+void RLERasterGrayscaleAA::fill_row(size_t row, uint8_t *dst) const
+{
+    std::memset(dst, 0, m_resolution.width_px);
+    for (const Run &run : m_rows[row])
+        std::memset(dst + run.x, run.value, run.len);
+}
+
+uint8_t RLERasterGrayscaleAA::read_pixel(size_t col, size_t row) const
+{
+    const Row &r  = m_rows[row];
+    auto       it = std::upper_bound(r.begin(), r.end(), col,
+                                     [](size_t x, const Run &run) { return x < run.x; });
+    if (it == r.begin())
+        return 0;
+
+    --it;
+    return col < size_t(it->x) + it->len ? it->value : 0;
+}
+
+EncodedRaster RLERasterGrayscaleAA::encode(RasterEncoder encoder) const
+{
+    size_t w = m_resolution.width_px, h = m_resolution.height_px;
+
+    if (PNGRasterEncoder *png = encoder.target<PNGRasterEncoder>())
+        return png->encode_rows([this](size_t row, uint8_t *dst) { fill_row(row, dst); }, w, h, 1);
+
+    // Other encoders need the full image.
+    std::vector<uint8_t> buf(m_resolution.pixels());
+    for (size_t row = 0; row < h; ++row)
+        fill_row(row, buf.data() + row * w);
+
+    return encoder(buf.data(), w, h, 1);
+}
+
+}} // namespace Slic3r::sla
@@ -0,0 +1,90 @@
+#ifndef SLA_RLERASTER_HPP
+#define SLA_RLERASTER_HPP
+
+#include <libslic3r/SLA/AGGRaster.hpp>
+
+namespace Slic3r { namespace sla {
+
+/*
+ * Anti-aliased monochrome canvas equivalent to RasterGrayscaleAA, which stores
+ * every row as a sorted list of runs of equal pixels instead of a full
+ * grayscale buffer. The black background is not stored at all, the interior
+ * of a polygon is a single run per row and only the anti-aliased edge pixels
+ * produce short runs. The scanlines of AGG are blended into the runs exactly
+ * like agg::renderer_scanline_aa_solid blends them into the pixels, thus the
+ * image is identical to the one of RasterGrayscaleAA.
+ *
+ * The PNG encoder is fed row by row, so the full image is never materialized.
+ */
+class RLERasterGrayscaleAA : public RasterBase, protected AGGPathConverter {
+public:
+    // Pixels [x, x + len) of a row with the same non-zero value.
+    struct Run {
+        uint32_t x     = 0;
+        uint32_t len   = 0;
+        uint8_t  value = 0;
+    };
+    using Row = std::vector<Run>;
+
+private:
+    std::vector<Row> m_rows;
+
+    agg::scanline_p8 m_scanlines;
+    agg::rasterizer_scanline_aa<> m_rasterizer;
+
+    // Coverage of the scanline being blended, kept to reuse the allocation.
+    Row m_covers;
+
+    void blend_scanline(const agg::scanline_p8 &sl);
+
+    template<class P> void _draw(const P &poly)
+    {
+        m_rasterizer.reset();
+        add_paths(m_rasterizer, poly);
+
+        // The same as agg::render_scanlines() with the runs as the renderer.
+        if (m_rasterizer.rewind_scanlines()) {
+            m_scanlines.reset(m_rasterizer.min_x(), m_rasterizer.max_x());
+            while (m_rasterizer.sweep_scanline(m_scanlines))
+                blend_scanline(m_scanlines);
+        }
+    }
+
+public:
+    template<class GammaFn>
+    RLERasterGrayscaleAA(const Resolution &res,
+                         const PixelDim &  pd,
+                         const Trafo &     trafo,
+                         GammaFn &&        gammafn)
+        : AGGPathConverter(res, pd, trafo)
+        , m_rows(res.height_px)
+    {
+        m_rasterizer.gamma(gammafn);
+    }
+
+    Trafo trafo() const override { return m_trafo; }
+    Resolution resolution() const override { return m_resolution; }
+    PixelDim   pixel_dimensions() const override
+    {
+        return {SCALING_FACTOR / m_pxdim_scaled.w_mm,
+                SCALING_FACTOR / m_pxdim_scaled.h_mm};
+    }
+
+    void draw(const ExPolygon &poly) override { _draw(poly); }
+    void draw(const ClipperLib::Polygon &poly) override { _draw(poly); }
+
+    EncodedRaster encode(RasterEncoder encoder) const override;
+
+    const Row& row(size_t row) const { return m_rows[row]; }
+
+    // Write the row-th row of the image into dst (width_px bytes).
+    void fill_row(size_t row, uint8_t *dst) const;
+
+    uint8_t read_pixel(size_t col, size_t row) const;
+
+    void clear() { for (Row &row : m_rows) Row().swap(row); }
+};
+
+}} // namespace Slic3r::sla
+
+#endif // SLA_RLERASTER_HPP
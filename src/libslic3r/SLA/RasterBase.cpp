@@ -5,6 +5,7 @@
 
 #include <libslic3r/SLA/RasterBase.hpp>
 #include <libslic3r/SLA/AGGRaster.hpp>
+#include <libslic3r/SLA/RLERaster.hpp>
 
 // minz image write:
 #include <miniz.h>
@@ -38,6 +39,64 @@ EncodedRaster PNGRasterEncoder::operator()(const void *ptr, size_t w, size_t h,
     return EncodedRaster(std::move(buf), "png");
 }
 
+EncodedRaster PNGRasterEncoder::encode_rows(const RasterRowFn &rowfn, size_t w,
+                                            size_t h, size_t num_components)
+{
+    // Mirrors tdefl_write_image_to_png_file_in_memory() with the default
+    // compression level, only the rows are fetched one by one.
+    static const uint8_t chans[] = { 0x00, 0x00, 0x04, 0x02, 0x06 };
+    static const size_t  hdr_size = 41;
+    
+    std::vector<uint8_t> buf(hdr_size, 0);
+    auto putter = [](const void *ptr, int len, void *user) -> mz_bool {
+        auto dst = static_cast<std::vector<uint8_t> *>(user);
+        auto src = static_cast<const uint8_t *>(ptr);
+        dst->insert(dst->end(), src, src + len);
+        return MZ_TRUE;
+    };
+    
+    auto comp = std::make_unique<tdefl_compressor>();
+    tdefl_init(comp.get(), putter, &buf,
+               int(tdefl_create_comp_flags_from_zip_params(MZ_DEFAULT_LEVEL, MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY)));
+    
+    std::vector<uint8_t> row(w * num_components + 1, 0); // filter type 0 + pixels
+    bool ok = true;
+    for (size_t y = 0; y < h && ok; ++y) {
+        rowfn(y, row.data() + 1);
+        ok = tdefl_compress_buffer(comp.get(), row.data(), row.size(), TDEFL_NO_FLUSH) == TDEFL_STATUS_OKAY;
+    }
+    
+    if (!ok || tdefl_compress_buffer(comp.get(), nullptr, 0, TDEFL_FINISH) != TDEFL_STATUS_DONE)
+        return EncodedRaster({}, "png");
+    
+    auto put_u32 = [](uint8_t *dst, uint32_t v) {
+        for (int i = 0; i < 4; ++i, v <<= 8) dst[i] = uint8_t(v >> 24);
+    };
+    
+    size_t idat_size = buf.size() - hdr_size;
+    uint8_t hdr[hdr_size] = { 0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a,
+                              0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+                              0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                              0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                              0x00, 0x00, 0x00, 0x00, 0x00, 0x49, 0x44, 0x41,
+                              0x54 };
+    put_u32(hdr + 16, uint32_t(w));
+    put_u32(hdr + 20, uint32_t(h));
+    hdr[25] = chans[num_components];
+    put_u32(hdr + 29, uint32_t(mz_crc32(MZ_CRC32_INIT, hdr + 12, 17)));
+    put_u32(hdr + 33, uint32_t(idat_size));
+    std::copy(hdr, hdr + hdr_size, buf.begin());
+    
+    // IDAT CRC-32, followed by the IEND chunk
+    static const uint8_t footer[] = { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+                                      0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82 };
+    buf.insert(buf.end(), std::begin(footer), std::end(footer));
+    put_u32(buf.data() + hdr_size + idat_size,
+            uint32_t(mz_crc32(MZ_CRC32_INIT, buf.data() + hdr_size - 4, idat_size + 4)));
+    
+    return EncodedRaster(std::move(buf), "png");
+}
+
 std::ostream &operator<<(std::ostream &stream, const EncodedRaster &bytes)
 {
     stream.write(reinterpret_cast<const char *>(bytes.data()),
@@ -83,6 +142,22 @@ std::unique_ptr<RasterBase> create_raster_grayscale_aa(
     return rst;
 }
 
+std::unique_ptr<RasterBase> create_raster_grayscale_aa_rle(
+    const RasterBase::Resolution &res,
+    const RasterBase::PixelDim &  pxdim,
+    double                        gamma,
+    const RasterBase::Trafo &     tr)
+{
+    std::unique_ptr<RasterBase> rst;
+    
+    if (gamma > 0)
+        rst = std::make_unique<RLERasterGrayscaleAA>(res, pxdim, tr, agg::gamma_power(gamma));
+    else
+        rst = std::make_unique<RLERasterGrayscaleAA>(res, pxdim, tr, agg::gamma_threshold(.5));
+    
+    return rst;
+}
+
 } // namespace sla
 } // namespace Slic3r
 
@@ -40,6 +40,9 @@ public:
 using RasterEncoder =
     std::function<EncodedRaster(const void *ptr, size_t w, size_t h, size_t num_components)>;
 
+// Fills the row-th row of a raster (w * num_components bytes) into dst.
+using RasterRowFn = std::function<void(size_t row, uint8_t *dst)>;
+
 class RasterBase {
 public:
     
@@ -104,6 +107,10 @@ public:
 
 struct PNGRasterEncoder {
     EncodedRaster operator()(const void *ptr, size_t w, size_t h, size_t num_components);
+    
+    // Produces the same PNG as operator(), but the image is pulled and
+    // compressed row by row, thus it never has to be in memory as a whole.
+    EncodedRaster encode_rows(const RasterRowFn &rowfn, size_t w, size_t h, size_t num_components);
 };
 
 struct PPMRasterEncoder {
@@ -119,6 +126,14 @@ uqptr<RasterBase> create_raster_grayscale_aa(
     double                        gamma = 1.0,
     const RasterBase::Trafo &     tr    = {});
 
+// The same as create_raster_grayscale_aa(), but the raster is stored as runs
+// of equal pixels per row instead of a full grayscale buffer, see RLERaster.hpp.
+uqptr<RasterBase> create_raster_grayscale_aa_rle(
+    const RasterBase::Resolution &res,
+    const RasterBase::PixelDim &  pxdim,
+    double                        gamma = 1.0,
+    const RasterBase::Trafo &     tr    = {});
+
 }} // namespace Slic3r::sla
 
 #endif // SLARASTERBASE_HPP
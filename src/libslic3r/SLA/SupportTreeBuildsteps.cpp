@@ -191,9 +191,6 @@ IndexedMesh::hit_result SupportTreeBuildsteps::pinhead_mesh_intersect(
     auto& m = m_mesh;
     using HitResult = IndexedMesh::hit_result;
 
-    // Hit results
-    std::array<HitResult, SAMPLES> hits;
-
     struct Rings {
         double rpin;
         double rback;
@@ -207,51 +204,64 @@ IndexedMesh::hit_result SupportTreeBuildsteps::pinhead_mesh_intersect(
 
     // We will shoot multiple rays from the head pinpoint in the direction
     // of the pinhead robe (side) surface. The result will be the smallest
-    // hit distance.
-
-    ccr::for_each(size_t(0), hits.size(),
-                  [&m, &rings, sd, &hits](size_t i) {
-
-       // Point on the circle on the pin sphere
-       Vec3d ps = rings.pinring(i);
-       // This is the point on the circle on the back sphere
-       Vec3d p = rings.backring(i);
-
-       auto &hit = hits[i];
-
-       // Point ps is not on mesh but can be inside or
-       // outside as well. This would cause many problems
-       // with ray-casting. To detect the position we will
-       // use the ray-casting result (which has an is_inside
-       // predicate).
-
-       Vec3d n = (p - ps).normalized();
-       auto  q = m.query_ray_hit(ps + sd * n, n);
-
-       if (q.is_inside()) { // the hit is inside the model
-           if (q.distance() > rings.rpin) {
-               // If we are inside the model and the hit
-               // distance is bigger than our pin circle
-               // diameter, it probably indicates that the
-               // support point was already inside the
-               // model, or there is really no space
-               // around the point. We will assign a zero
-               // hit distance to these cases which will
-               // enforce the function return value to be
-               // an invalid ray with zero hit distance.
-               // (see min_element at the end)
-               hit = HitResult(0.0);
-           } else {
-               // re-cast the ray from the outside of the
-               // object. The starting point has an offset
-               // of 2*safety_distance because the
-               // original ray has also had an offset
-               auto q2 = m.query_ray_hit(ps + (q.distance() + 2 * sd) * n, n);
-               hit = q2;
-           }
-       } else
-           hit = q;
-    });
+    // hit distance. The rays are cast together as a single packet.
+
+    std::vector<Vec3d> pins(SAMPLES), sources(SAMPLES), dirs(SAMPLES);
+    for (size_t i = 0; i < SAMPLES; ++i) {
+        // Point on the circle on the pin sphere
+        pins[i] = rings.pinring(i);
+        // This is the point on the circle on the back sphere
+        Vec3d p = rings.backring(i);
+
+        // Point ps is not on mesh but can be inside or
+        // outside as well. This would cause many problems
+        // with ray-casting. To detect the position we will
+        // use the ray-casting result (which has an is_inside
+        // predicate).
+
+        dirs[i]    = (p - pins[i]).normalized();
+        sources[i] = pins[i] + sd * dirs[i];
+    }
+
+    // Hit results
+    std::vector<HitResult> hits = m.query_rays_hit(sources, dirs);
+
+    // Rays to be re-cast from the outside of the object.
+    std::vector<size_t> recast;
+    std::vector<Vec3d>  recast_sources, recast_dirs;
+
+    for (size_t i = 0; i < SAMPLES; ++i) {
+        auto &hit = hits[i];
+        if (hit.is_inside()) { // the hit is inside the model
+            if (hit.distance() > rings.rpin) {
+                // If we are inside the model and the hit
+                // distance is bigger than our pin circle
+                // diameter, it probably indicates that the
+                // support point was already inside the
+                // model, or there is really no space
+                // around the point. We will assign a zero
+                // hit distance to these cases which will
+                // enforce the function return value to be
+                // an invalid ray with zero hit distance.
+                // (see min_element at the end)
+                hit = HitResult(0.0);
+            } else {
+                // re-cast the ray from the outside of the
+                // object. The starting point has an offset
+                // of 2*safety_distance because the
+                // original ray has also had an offset
+                recast.emplace_back(i);
+                recast_sources.emplace_back(pins[i] + (hit.distance() + 2 * sd) * dirs[i]);
+                recast_dirs.emplace_back(dirs[i]);
+            }
+        }
+    }
+
+    if (! recast.empty()) {
+        std::vector<HitResult> recast_hits = m.query_rays_hit(recast_sources, recast_dirs);
+        for (size_t i = 0; i < recast.size(); ++i)
+            hits[recast[i]] = recast_hits[i];
+    }
 
     return min_hit(hits);
 }
@@ -264,27 +274,39 @@ IndexedMesh::hit_result SupportTreeBuildsteps::bridge_mesh_intersect(
 
     using Hit = IndexedMesh::hit_result;
 
-    // Hit results
-    std::array<Hit, SAMPLES> hits;
-
-    ccr::for_each(size_t(0), hits.size(),
-                 [this, r, src, /*ins_check,*/ &ring, dir, sd, &hits] (size_t i)
-    {
-        Hit &hit = hits[i];
-
+    // The rays are cast together as a single packet.
+    std::vector<Vec3d> points(SAMPLES), sources(SAMPLES), dirs(SAMPLES, dir);
+    for (size_t i = 0; i < SAMPLES; ++i) {
         // Point on the circle on the pin sphere
-        Vec3d p = ring.get(i, src, r + sd);
+        points[i]  = ring.get(i, src, r + sd);
+        sources[i] = points[i] + r * dir;
+    }
+
+    // Hit results
+    std::vector<Hit> hits = m_mesh.query_rays_hit(sources, dirs);
 
-        auto hr = m_mesh.query_ray_hit(p + r * dir, dir);
+    // Rays to be re-cast from the outside of the object.
+    std::vector<size_t> recast;
+    std::vector<Vec3d>  recast_sources;
 
-        if(/*ins_check && */hr.is_inside()) {
-            if(hr.distance() > 2 * r + sd) hit = Hit(0.0);
+    for (size_t i = 0; i < SAMPLES; ++i) {
+        Hit &hit = hits[i];
+        if(/*ins_check && */hit.is_inside()) {
+            if(hit.distance() > 2 * r + sd) hit = Hit(0.0);
             else {
                 // re-cast the ray from the outside of the object
-                hit = m_mesh.query_ray_hit(p + (hr.distance() + EPSILON) * dir, dir);
+                recast.emplace_back(i);
+                recast_sources.emplace_back(points[i] + (hit.distance() + EPSILON) * dir);
             }
-        } else hit = hr;
-    });
+        }
+    }
+
+    if (! recast.empty()) {
+        std::vector<Hit> recast_hits = m_mesh.query_rays_hit(
+            recast_sources, std::vector<Vec3d>(recast.size(), dir));
+        for (size_t i = 0; i < recast.size(); ++i)
+            hits[recast[i]] = recast_hits[i];
+    }
 
     return min_hit(hits);
 }
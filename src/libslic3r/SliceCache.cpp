@@ -0,0 +1,327 @@
+#include "SliceCache.hpp"
+
+#include <iterator>
+#include <memory>
+
+#include <boost/algorithm/hex.hpp>
+#include <boost/filesystem.hpp>
+#include <boost/log/trivial.hpp>
+#include <boost/nowide/fstream.hpp>
+
+namespace Slic3r {
+
+std::string SliceCache::Hasher::digest()
+{
+    // boost::uuids::detail::md5 is an internal namespace thus it may change in the future, see AppConfig.cpp.
+    // MD5 is good enough there, the cache keys are not exposed to an adversary.
+    boost::uuids::detail::md5::digest_type md5_digest{};
+    m_md5.get_digest(md5_digest);
+    std::string out;
+    boost::algorithm::hex(md5_digest, md5_digest + std::size(md5_digest), std::back_inserter(out));
+    return out;
+}
+
+// Tags of the ExtrusionEntity types stored by the Writer.
+enum class ExtrusionEntityTag : uint8_t {
+    Path,
+    Path3D,
+    MultiPath,
+    MultiPath3D,
+    Loop,
+    Collection,
+};
+
+void SliceCache::Writer::write(const Polylines &polylines)
+{
+    this->write(uint32_t(polylines.size()));
+    for (const Polyline &polyline : polylines)
+        this->write(polyline);
+}
+
+void SliceCache::Writer::write(const ExPolygon &expolygon)
+{
+    this->write(expolygon.contour);
+    this->write(uint32_t(expolygon.holes.size()));
+    for (const Polygon &hole : expolygon.holes)
+        this->write(hole);
+}
+
+void SliceCache::Writer::write(const ExPolygons &expolygons)
+{
+    this->write(uint32_t(expolygons.size()));
+    for (const ExPolygon &expolygon : expolygons)
+        this->write(expolygon);
+}
+
+void SliceCache::Writer::write(const Surface &surface)
+{
+    this->write(surface.surface_type);
+    this->write(surface.expolygon);
+    this->write(surface.thickness);
+    this->write(surface.thickness_layers);
+    this->write(surface.bridge_angle);
+    this->write(surface.extra_perimeters);
+    this->write(surface.maxNbSolidLayersOnTop);
+    this->write(surface.priority);
+}
+
+void SliceCache::Writer::write(const Surfaces &surfaces)
+{
+    this->write(uint32_t(surfaces.size()));
+    for (const Surface &surface : surfaces)
+        this->write(surface);
+}
+
+class ExtrusionEntityWriter : public ExtrusionVisitorConst {
+public:
+    ExtrusionEntityWriter(SliceCache::Writer &writer) : m_writer(writer) {}
+
+    void use(const ExtrusionPath &path) override {
+        m_writer.write(ExtrusionEntityTag::Path);
+        this->write_path(path);
+    }
+    void use(const ExtrusionPath3D &path3D) override {
+        m_writer.write(ExtrusionEntityTag::Path3D);
+        this->write_path(path3D);
+    }
+    void use(const ExtrusionMultiPath &multipath) override {
+        m_writer.write(ExtrusionEntityTag::MultiPath);
+        m_writer.write(uint32_t(multipath.paths.size()));
+        for (const ExtrusionPath &path : multipath.paths)
+            this->write_path(path);
+    }
+    void use(const ExtrusionMultiPath3D &multipath3D) override {
+        m_writer.write(ExtrusionEntityTag::MultiPath3D);
+        m_writer.write(uint32_t(multipath3D.paths.size()));
+        for (const ExtrusionPath3D &path : multipath3D.paths)
+            this->write_path(path);
+    }
+    void use(const ExtrusionLoop &loop) override {
+        m_writer.write(ExtrusionEntityTag::Loop);
+        m_writer.write(loop.loop_role());
+        m_writer.write(uint32_t(loop.paths.size()));
+        for (const ExtrusionPath &path : loop.paths)
+            this->write_path(path);
+    }
+    void use(const ExtrusionEntityCollection &collection) override {
+        m_writer.write(ExtrusionEntityTag::Collection);
+        m_writer.write(collection.no_sort);
+        m_writer.write(uint32_t(collection.entities.size()));
+        for (const ExtrusionEntity *entity : collection.entities)
+            entity->visit(*this);
+    }
+
+private:
+    void write_path(const ExtrusionPath &path) {
+        m_writer.write(path.role());
+        m_writer.write(path.mm3_per_mm);
+        m_writer.write(path.width);
+        m_writer.write(path.height);
+        m_writer.write(path.polyline);
+    }
+    void write_path(const ExtrusionPath3D &path) {
+        this->write_path(static_cast<const ExtrusionPath&>(path));
+        m_writer.write(uint32_t(path.z_offsets.size()));
+        for (coord_t z_offset : path.z_offsets)
+            m_writer.write(z_offset);
+    }
+
+    SliceCache::Writer &m_writer;
+};
+
+void SliceCache::Writer::write(const ExtrusionEntityCollection &collection)
+{
+    ExtrusionEntityWriter visitor(*this);
+    collection.visit(visitor);
+}
+
+size_t SliceCache::Reader::read_count(size_t item_size)
+{
+    size_t cnt = size_t(this->read<uint32_t>());
+    // Don't allocate for a corrupted count.
+    if (m_ok && cnt * item_size > size_t(m_end - m_ptr))
+        m_ok = false;
+    return m_ok ? cnt : 0;
+}
+
+void SliceCache::Reader::read(Points &points)
+{
+    size_t cnt = this->read_count(sizeof(Point));
+    points.assign(cnt, Point());
+    if (cnt > 0 && this->fetch(cnt * sizeof(Point)))
+        memcpy(reinterpret_cast<char*>(points.data()), m_ptr - cnt * sizeof(Point), cnt * sizeof(Point));
+}
+
+void SliceCache::Reader::read(Polylines &polylines)
+{
+    polylines.assign(this->read_count(sizeof(uint32_t)), Polyline());
+    for (Polyline &polyline : polylines)
+        this->read(polyline);
+}
+
+void SliceCache::Reader::read(ExPolygon &expolygon)
+{
+    this->read(expolygon.contour);
+    // An empty hole still stores its point count.
+    expolygon.holes.assign(this->read_count(sizeof(uint32_t)), Polygon());
+    for (Polygon &hole : expolygon.holes)
+        this->read(hole);
+}
+
+void SliceCache::Reader::read(ExPolygons &expolygons)
+{
+    expolygons.assign(this->read_count(sizeof(uint32_t)), ExPolygon());
+    for (ExPolygon &expolygon : expolygons)
+        this->read(expolygon);
+}
+
+void SliceCache::Reader::read(Surfaces &surfaces)
+{
+    size_t cnt = this->read_count(sizeof(uint32_t));
+    surfaces.clear();
+    surfaces.reserve(cnt);
+    for (size_t i = 0; i < cnt && m_ok; ++ i) {
+        SurfaceType surface_type = this->read<SurfaceType>();
+        ExPolygon   expolygon;
+        this->read(expolygon);
+        surfaces.emplace_back(surface_type, std::move(expolygon));
+        Surface &surface = surfaces.back();
+        surface.thickness             = this->read<double>();
+        surface.thickness_layers      = this->read<unsigned short>();
+        surface.bridge_angle          = this->read<double>();
+        surface.extra_perimeters      = this->read<unsigned short>();
+        surface.maxNbSolidLayersOnTop = this->read<uint16_t>();
+        surface.priority              = this->read<uint16_t>();
+    }
+}
+
+void SliceCache::Reader::read(ExtrusionPath &path)
+{
+    path.set_role(this->read<ExtrusionRole>());
+    path.mm3_per_mm = this->read<double>();
+    path.width      = this->read<float>();
+    path.height     = this->read<float>();
+    this->read(path.polyline);
+}
+
+void SliceCache::Reader::read(ExtrusionPaths &paths)
+{
+    paths.assign(this->read_count(sizeof(uint32_t)), ExtrusionPath(erNone));
+    for (ExtrusionPath &path : paths)
+        this->read(path);
+}
+
+ExtrusionEntity* SliceCache::Reader::read_extrusion_entity()
+{
+    auto read_path3D = [this](ExtrusionPath3D &path) {
+        this->read(static_cast<ExtrusionPath&>(path));
+        path.z_offsets.assign(this->read_count(sizeof(coord_t)), 0);
+        for (coord_t &z_offset : path.z_offsets)
+            z_offset = this->read<coord_t>();
+    };
+    std::unique_ptr<ExtrusionEntity> out;
+    switch (this->read<ExtrusionEntityTag>()) {
+    case ExtrusionEntityTag::Path: {
+        auto path = std::make_unique<ExtrusionPath>(erNone);
+        this->read(*path);
+        out = std::move(path);
+        break;
+    }
+    case ExtrusionEntityTag::Path3D: {
+        auto path = std::make_unique<ExtrusionPath3D>(erNone);
+        read_path3D(*path);
+        out = std::move(path);
+        break;
+    }
+    case ExtrusionEntityTag::MultiPath: {
+        auto multipath = std::make_unique<ExtrusionMultiPath>();
+        this->read(multipath->paths);
+        out = std::move(multipath);
+        break;
+    }
+    case ExtrusionEntityTag::MultiPath3D: {
+        auto multipath = std::make_unique<ExtrusionMultiPath3D>();
+        multipath->paths.assign(this->read_count(sizeof(uint32_t)), ExtrusionPath3D(erNone));
+        for (ExtrusionPath3D &path : multipath->paths)
+            read_path3D(path);
+        out = std::move(multipath);
+        break;
+    }
+    case ExtrusionEntityTag::Loop: {
+        ExtrusionLoopRole loop_role = this->read<ExtrusionLoopRole>();
+        ExtrusionPaths    paths;
+        this->read(paths);
+        // Don't construct a loop from an invalid blob, the constructor asserts the loop to be closed.
+        if (m_ok && ! paths.empty())
+            out = std::make_unique<ExtrusionLoop>(std::move(paths), loop_role);
+        else
+            m_ok = false;
+        break;
+    }
+    case ExtrusionEntityTag::Collection: {
+        auto collection = std::make_unique<ExtrusionEntityCollection>();
+        collection->no_sort = this->read<bool>();
+        size_t cnt = this->read_count(sizeof(ExtrusionEntityTag));
+        collection->entities.reserve(cnt);
+        for (size_t i = 0; i < cnt && m_ok; ++ i)
+            if (ExtrusionEntity *entity = this->read_extrusion_entity(); entity != nullptr)
+                collection->entities.emplace_back(entity);
+        out = std::move(collection);
+        break;
+    }
+    default:
+        m_ok = false;
+    }
+    return m_ok ? out.release() : nullptr;
+}
+
+void SliceCache::Reader::read(ExtrusionEntityCollection &collection)
+{
+    collection.clear();
+    std::unique_ptr<ExtrusionEntity> entity(this->read_extrusion_entity());
+    if (entity && entity->is_collection())
+        collection = std::move(*static_cast<ExtrusionEntityCollection*>(entity.get()));
+    else
+        m_ok = false;
+}
+
+bool SliceCache::load(const std::string &key, std::string &data) const
+{
+    boost::filesystem::path path = boost::filesystem::path(m_directory) / key;
+    boost::nowide::ifstream ifs(path.string(), std::ios::in | std::ios::binary);
+    if (! ifs.good())
+        return false;
+    data.assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    if (ifs.bad()) {
+        BOOST_LOG_TRIVIAL(error) << "Failed reading slice cache entry " << path.string();
+        return false;
+    }
+    return true;
+}
+
+void SliceCache::store(const std::string &key, const std::string &data) const
+{
+    boost::system::error_code ec;
+    boost::filesystem::path   dir(m_directory);
+    boost::filesystem::create_directories(dir, ec);
+    // Write into a unique temporary file first and rename it then, so that a concurrent reader never sees a partial entry.
+    boost::filesystem::path path     = dir / key;
+    boost::filesystem::path path_tmp = dir / (key + boost::filesystem::unique_path(".%%%%-%%%%.tmp").string());
+    {
+        boost::nowide::ofstream ofs(path_tmp.string(), std::ios::out | std::ios::binary | std::ios::trunc);
+        ofs.write(data.data(), std::streamsize(data.size()));
+        ofs.close();
+        if (ofs.fail()) {
+            BOOST_LOG_TRIVIAL(error) << "Failed writing slice cache entry " << path_tmp.string();
+            boost::filesystem::remove(path_tmp, ec);
+            return;
+        }
+    }
+    boost::filesystem::rename(path_tmp, path, ec);
+    if (ec) {
+        BOOST_LOG_TRIVIAL(error) << "Failed storing slice cache entry " << path.string() << ": " << ec.message();
+        boost::filesystem::remove(path_tmp, ec);
+    }
+}
+
+} // namespace Slic3r
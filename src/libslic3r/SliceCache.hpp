@@ -0,0 +1,140 @@
+#ifndef slic3r_SliceCache_hpp_
+#define slic3r_SliceCache_hpp_
+
+#include "libslic3r.h"
+#include "ExPolygon.hpp"
+#include "ExtrusionEntityCollection.hpp"
+#include "Polyline.hpp"
+#include "Surface.hpp"
+
+#include <cstring>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#include <boost/uuid/detail/md5.hpp>
+
+namespace Slic3r {
+
+// On-disk cache of intermediate slicing results, shared by all the prints using the same cache directory.
+// The cache is content addressed: an entry is stored into a file named by a hash of all the inputs
+// of the cached computation, thus an entry never has to be invalidated, it is just not looked up anymore
+// once any of its inputs changes. The entries are written atomically, therefore the cache directory may be shared
+// by concurrent slicing processes.
+class SliceCache
+{
+public:
+    // Accumulates the inputs of a cached computation into a 128 bit hash.
+    class Hasher
+    {
+    public:
+        void add(const void *data, size_t size) { m_md5.process_bytes(data, size); }
+        template<typename T> void add(const T &value) {
+            static_assert(std::is_trivially_copyable<T>::value, "SliceCache::Hasher::add(): only trivially copyable types are hashed as raw bytes");
+            this->add(&value, sizeof(T));
+        }
+        void add(const std::string &value) { this->add(value.size()); this->add(value.data(), value.size()); }
+        template<typename T> void add(const std::vector<T> &values) {
+            static_assert(std::is_trivially_copyable<T>::value, "SliceCache::Hasher::add(): only trivially copyable types are hashed as raw bytes");
+            this->add(values.size());
+            this->add(values.data(), values.size() * sizeof(T));
+        }
+        // Hexadecimal string of the hash, to be used as a SliceCache key.
+        std::string digest();
+
+    private:
+        boost::uuids::detail::md5 m_md5;
+    };
+
+    // Serializes the cached data into a compact binary blob.
+    class Writer
+    {
+    public:
+        template<typename T> void write(const T &value) {
+            static_assert(std::is_trivially_copyable<T>::value, "SliceCache::Writer::write(): only trivially copyable types are stored as raw bytes");
+            m_data.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+        void write(const Points &points) {
+            this->write(uint32_t(points.size()));
+            m_data.append(reinterpret_cast<const char*>(points.data()), points.size() * sizeof(Point));
+        }
+        void write(const Polygon   &polygon)    { this->write(polygon.points); }
+        void write(const Polyline  &polyline)   { this->write(polyline.points); }
+        void write(const Polylines &polylines);
+        void write(const ExPolygon &expolygon);
+        void write(const ExPolygons &expolygons);
+        void write(const Surface &surface);
+        void write(const Surfaces &surfaces);
+        // Writes the collection including all its nested extrusion entities.
+        void write(const ExtrusionEntityCollection &collection);
+
+        const std::string& data() const { return m_data; }
+
+    private:
+        std::string m_data;
+    };
+
+    // Deserializes a blob produced by Writer. Reading past the end of the blob does not throw,
+    // it just fails the reader, thus the caller only needs to check ok() once all the data was read.
+    class Reader
+    {
+    public:
+        explicit Reader(const std::string &data) : m_ptr(data.data()), m_end(data.data() + data.size()) {}
+
+        template<typename T> T read() {
+            static_assert(std::is_trivially_copyable<T>::value, "SliceCache::Reader::read(): only trivially copyable types are stored as raw bytes");
+            T value {};
+            if (this->fetch(sizeof(T)))
+                memcpy(&value, m_ptr - sizeof(T), sizeof(T));
+            return value;
+        }
+        void read(Points &points);
+        void read(Polygon &polygon) { this->read(polygon.points); }
+        void read(Polyline &polyline) { this->read(polyline.points); }
+        void read(Polylines &polylines);
+        void read(ExPolygon &expolygon);
+        void read(ExPolygons &expolygons);
+        void read(Surfaces &surfaces);
+        void read(ExtrusionEntityCollection &collection);
+
+        bool ok() const { return m_ok; }
+        bool at_end() const { return m_ptr == m_end; }
+
+    private:
+        // Advance by size bytes if there are size bytes left, otherwise fail the reader.
+        bool fetch(size_t size) {
+            if (m_ok && size_t(m_end - m_ptr) >= size) {
+                m_ptr += size;
+                return true;
+            }
+            m_ok = false;
+            return false;
+        }
+        // Number of items to be read, failing the reader if the remaining data cannot hold them.
+        size_t read_count(size_t item_size);
+        void read(ExtrusionPath &path);
+        void read(ExtrusionPaths &paths);
+        // Returns nullptr if the reader failed.
+        ExtrusionEntity* read_extrusion_entity();
+
+        const char *m_ptr;
+        const char *m_end;
+        bool        m_ok { true };
+    };
+
+    explicit SliceCache(const std::string &directory) : m_directory(directory) {}
+
+    const std::string& directory() const { return m_directory; }
+
+    // Load a cache entry. Returns false if there is no entry for the key, or if the entry could not be read.
+    bool load(const std::string &key, std::string &data) const;
+    // Store a cache entry. Failing to store an entry is not an error, the entry is just not cached.
+    void store(const std::string &key, const std::string &data) const;
+
+private:
+    std::string m_directory;
+};
+
+} // namespace Slic3r
+
+#endif // slic3r_SliceCache_hpp_
@@ -513,9 +513,9 @@ public:
         assert(std::abs(2 * offset_in_grid) < m_grid.resolution());
 #ifdef SLIC3R_DEBUG
         Polygons   support_polygons_simplified = m_grid.contours_simplified(offset_in_grid, fill_holes);
-        ExPolygons islands = diff_ex(support_polygons_simplified, *m_trimming_polygons, false);
+        ExPolygons islands = diff_ex_clipped(support_polygons_simplified, *m_trimming_polygons, false);
 #else
-        ExPolygons islands = diff_ex(m_grid.contours_simplified(offset_in_grid, fill_holes), *m_trimming_polygons, false);
+        ExPolygons islands = diff_ex_clipped(m_grid.contours_simplified(offset_in_grid, fill_holes), *m_trimming_polygons, false);
 #endif
 
         // Extract polygons, which contain some of the m_island_samples.
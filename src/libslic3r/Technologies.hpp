@@ -118,4 +118,12 @@
 #define ENABLE_REDUCED_TOOLPATHS_SEGMENT_CAPS (1 && ENABLE_SPLITTED_VERTEX_BUFFER)
 
 
+//===================
+// G-code export techs
+//===================
+// Process the G-code with the GCodeProcessor while it is being exported, instead of reading the exported file back
+// with GCodeProcessor::process_file().
+#define ENABLE_GCODE_PROCESSING_WHILE_EXPORTING 1
+
+
 #endif // _prusaslicer_technologies_h_
@@ -12,6 +12,7 @@
 #include <set>
 #include <vector>
 #include <map>
+#include <numeric>
 #include <utility>
 #include <algorithm>
 #include <math.h>
@@ -20,6 +21,8 @@
 #include <boost/log/trivial.hpp>
 
 #include <tbb/parallel_for.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
 
 #include <Eigen/Core>
 #include <Eigen/Dense>
@@ -810,39 +813,84 @@ void TriangleMeshSlicer::slice(
         type is float.
     */
     
-    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_slice_do";
-    std::vector<IntersectionLines> lines(z.size());
-    {
-        boost::mutex lines_mutex;
-        tbb::parallel_for(
-            tbb::blocked_range<int>(0,this->mesh->stl.stats.number_of_facets),
-            [&lines, &lines_mutex, &z, throw_on_cancel, this](const tbb::blocked_range<int>& range) {
-                for (int facet_idx = range.begin(); facet_idx < range.end(); ++ facet_idx) {
-                    if ((facet_idx & 0x0ffff) == 0)
-                        throw_on_cancel();
-                    this->_slice_do(facet_idx, &lines, &lines_mutex, z);
-                }
+    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::slice - sorting facets";
+    // Z extents of the facets, stored as separate arrays to be scanned quickly by the sweep below.
+    const size_t          num_facets = this->mesh->stl.stats.number_of_facets;
+    std::vector<float>    facets_min_z(num_facets);
+    std::vector<float>    facets_max_z(num_facets);
+    tbb::parallel_for(
+        tbb::blocked_range<size_t>(0, num_facets),
+        [&facets_min_z, &facets_max_z, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
+            for (size_t facet_idx = range.begin(); facet_idx < range.end(); ++ facet_idx) {
+                if ((facet_idx & 0x0ffff) == 0)
+                    throw_on_cancel();
+                const stl_facet &facet = m_use_quaternion ? this->mesh->stl.facet_start[facet_idx].rotated(m_quaternion) : this->mesh->stl.facet_start[facet_idx];
+                facets_min_z[facet_idx] = fminf(facet.vertex[0](2), fminf(facet.vertex[1](2), facet.vertex[2](2)));
+                facets_max_z[facet_idx] = fmaxf(facet.vertex[0](2), fmaxf(facet.vertex[1](2), facet.vertex[2](2)));
             }
-        );
-    }
+        }
+    );
+    // Facets sorted by their minimum Z, the facet index makes the order deterministic.
+    std::vector<uint32_t> facets_sorted(num_facets);
+    std::iota(facets_sorted.begin(), facets_sorted.end(), 0);
+    tbb::parallel_sort(facets_sorted.begin(), facets_sorted.end(), [&facets_min_z](const uint32_t i1, const uint32_t i2) 
+        { return facets_min_z[i1] < facets_min_z[i2] || (facets_min_z[i1] == facets_min_z[i2] && i1 < i2); });
+    // A facet active at some Z starts at most max_facet_height below Z.
+    float max_facet_height = 0.f;
+    for (size_t facet_idx = 0; facet_idx < num_facets; ++ facet_idx)
+        max_facet_height = std::max(max_facet_height, facets_max_z[facet_idx] - facets_min_z[facet_idx]);
     throw_on_cancel();
 
-    // v_scaled_shared could be freed here
-    
-    // build loops
-    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::_make_loops_do";
-    layers->resize(z.size());
+    // Sweep the layers in Z, keeping the list of the facets crossing the current layer.
+    // Each thread sweeps a continuous range of layers and chains the intersection lines of a layer into loops
+    // right after the layer is sliced, so that the intersection lines of all the layers are never held in memory together.
+    BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::slice - sweeping layers";
+    layers->assign(z.size(), Polygons());
+#ifdef SLIC3R_DEBUG
+    std::vector<IntersectionLines> lines(z.size());
+#endif
     tbb::parallel_for(
-        tbb::blocked_range<size_t>(0, z.size()),
-        [&lines, &layers, mode, alternate_mode_first_n_layers, alternate_mode, throw_on_cancel, this](const tbb::blocked_range<size_t>& range) {
-            for (size_t line_idx = range.begin(); line_idx < range.end(); ++ line_idx) {
-                if ((line_idx & 0x0ffff) == 0)
-                    throw_on_cancel();
+        tbb::blocked_range<size_t>(0, z.size(), std::max<size_t>(1, z.size() / (4 * size_t(tbb::this_task_arena::max_concurrency())))),
+        [&z, &facets_min_z, &facets_max_z, &facets_sorted, max_facet_height, &layers, mode, alternate_mode_first_n_layers, alternate_mode, throw_on_cancel, 
+#ifdef SLIC3R_DEBUG
+            &lines,
+#endif
+            this](const tbb::blocked_range<size_t>& range) {
+            auto min_z_lower = [&facets_min_z](const uint32_t facet_idx, const float z) { return facets_min_z[facet_idx] < z; };
+            auto min_z_upper = [&facets_min_z](const float z, const uint32_t facet_idx) { return z < facets_min_z[facet_idx]; };
+            // Facets active at the first layer of this range. Only the facets starting less than max_facet_height below the layer are tested,
+            // with a margin for the rounding errors.
+            std::vector<uint32_t> active;
+            size_t                next = std::upper_bound(facets_sorted.begin(), facets_sorted.end(), z[range.begin()], min_z_upper) - facets_sorted.begin();
+            for (auto it = std::lower_bound(facets_sorted.begin(), facets_sorted.begin() + next, z[range.begin()] - max_facet_height - 1.f, min_z_lower); 
+                it != facets_sorted.begin() + next; ++ it)
+                if (facets_max_z[*it] >= z[range.begin()])
+                    active.emplace_back(*it);
+            IntersectionLines layer_lines;
+            for (size_t layer_idx = range.begin(); layer_idx < range.end(); ++ layer_idx) {
+                throw_on_cancel();
+                const float slice_z = z[layer_idx];
+                // Activate the facets starting below this layer, deactivate the facets ending below this layer.
+                for (; next < facets_sorted.size() && facets_min_z[facets_sorted[next]] <= slice_z; ++ next)
+                    active.emplace_back(facets_sorted[next]);
+                active.erase(std::remove_if(active.begin(), active.end(), [&facets_max_z, slice_z](const uint32_t facet_idx) { return facets_max_z[facet_idx] < slice_z; }), active.end());
+                layer_lines.clear();
+                for (const uint32_t facet_idx : active) {
+                    const stl_facet &facet = m_use_quaternion ? this->mesh->stl.facet_start[facet_idx].rotated(m_quaternion) : this->mesh->stl.facet_start[facet_idx];
+                    IntersectionLine il;
+                    if (this->slice_facet(slice_z / SCALING_FACTOR, facet, facet_idx, facets_min_z[facet_idx], facets_max_z[facet_idx], &il) == TriangleMeshSlicer::Slicing &&
+                        // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
+                        il.edge_type != feHorizontal)
+                        layer_lines.emplace_back(il);
+                }
+#ifdef SLIC3R_DEBUG
+                lines[layer_idx] = layer_lines;
+#endif
 
-                Polygons &polygons = (*layers)[line_idx];
-                this->make_loops(lines[line_idx], &polygons);
+                Polygons &polygons = (*layers)[layer_idx];
+                this->make_loops(layer_lines, &polygons);
 
-                auto this_mode = line_idx < alternate_mode_first_n_layers ? alternate_mode : mode;
+                auto this_mode = layer_idx < alternate_mode_first_n_layers ? alternate_mode : mode;
                 if (! polygons.empty()) {
                     if (this_mode == SlicingMode::Positive) {
                         // Reorient all loops to be CCW.
@@ -868,7 +916,8 @@ void TriangleMeshSlicer::slice(
                     }
                 }
             }
-        }
+        },
+        tbb::simple_partitioner()
     );
     BOOST_LOG_TRIVIAL(debug) << "TriangleMeshSlicer::slice finished";
 
@@ -906,44 +955,6 @@ void TriangleMeshSlicer::slice(
 #endif
 }
 
-void TriangleMeshSlicer::_slice_do(size_t facet_idx, std::vector<IntersectionLines>* lines, boost::mutex* lines_mutex, 
-    const std::vector<float> &z) const
-{
-    const stl_facet &facet = m_use_quaternion ? (this->mesh->stl.facet_start.data() + facet_idx)->rotated(m_quaternion) : *(this->mesh->stl.facet_start.data() + facet_idx);
-    
-    // find facet extents
-    const float min_z = fminf(facet.vertex[0](2), fminf(facet.vertex[1](2), facet.vertex[2](2)));
-    const float max_z = fmaxf(facet.vertex[0](2), fmaxf(facet.vertex[1](2), facet.vertex[2](2)));
-    
-    #ifdef SLIC3R_TRIANGLEMESH_DEBUG
-    printf("\n==> FACET %d (%f,%f,%f - %f,%f,%f - %f,%f,%f):\n", facet_idx,
-        facet.vertex[0](0), facet.vertex[0](1), facet.vertex[0](2),
-        facet.vertex[1](0), facet.vertex[1](1), facet.vertex[1](2),
-        facet.vertex[2](0), facet.vertex[2](1), facet.vertex[2](2));
-    printf("z: min = %.2f, max = %.2f\n", min_z, max_z);
-    #endif /* SLIC3R_TRIANGLEMESH_DEBUG */
-    
-    // find layer extents
-    std::vector<float>::const_iterator min_layer, max_layer;
-    min_layer = std::lower_bound(z.begin(), z.end(), min_z); // first layer whose slice_z is >= min_z
-    max_layer = std::upper_bound(min_layer, z.end(), max_z); // first layer whose slice_z is > max_z
-    #ifdef SLIC3R_TRIANGLEMESH_DEBUG
-    printf("layers: min = %d, max = %d\n", (int)(min_layer - z.begin()), (int)(max_layer - z.begin()));
-    #endif /* SLIC3R_TRIANGLEMESH_DEBUG */
-    
-    for (std::vector<float>::const_iterator it = min_layer; it != max_layer; ++ it) {
-        std::vector<float>::size_type layer_idx = it - z.begin();
-        IntersectionLine il;
-        if (this->slice_facet(*it / SCALING_FACTOR, facet, facet_idx, min_z, max_z, &il) == TriangleMeshSlicer::Slicing) {
-            boost::lock_guard<boost::mutex> l(*lines_mutex);
-            if (il.edge_type == feHorizontal) {
-                // Ignore horizontal triangles. Any valid horizontal triangle must have a vertical triangle connected, otherwise the part has zero volume.
-            } else
-                (*lines)[layer_idx].emplace_back(il);
-        }
-    }
-}
-
 void TriangleMeshSlicer::slice(
     const std::vector<float> &z, SlicingMode mode, size_t alternate_mode_first_n_layers, SlicingMode alternate_mode,
     std::vector<ExPolygons>* layers, throw_on_cancel_callback_type throw_on_cancel) const
@@ -1227,21 +1238,21 @@ struct OpenPolyline {
     bool                    consumed;
 };
 
-// called by TriangleMeshSlicer::make_loops() to connect sliced triangles into closed loops and open polylines by the triangle connectivity.
-// Only connects segments crossing triangles of the same orientation.
-static void chain_lines_by_triangle_connectivity(std::vector<IntersectionLine> &lines, Polygons &loops, std::vector<OpenPolyline> &open_polylines)
+// Chain the lines of a single connected component (or of the whole layer) with a greedy algorithm.
+// The lines are seeded in the order of the "lines" vector.
+static void chain_lines_by_triangle_connectivity_serial(const IntersectionLinePtrs &lines, Polygons &loops, std::vector<OpenPolyline> &open_polylines)
 {
     // Build a map of lines by edge_a_id and a_id.
     std::vector<IntersectionLine*> by_edge_a_id;
     std::vector<IntersectionLine*> by_a_id;
     by_edge_a_id.reserve(lines.size());
     by_a_id.reserve(lines.size());
-    for (IntersectionLine &line : lines) {
-        if (! line.skip()) {
-            if (line.edge_a_id != -1)
-                by_edge_a_id.emplace_back(&line);
-            if (line.a_id != -1)
-                by_a_id.emplace_back(&line);
+    for (IntersectionLine *line : lines) {
+        if (! line->skip()) {
+            if (line->edge_a_id != -1)
+                by_edge_a_id.emplace_back(line);
+            if (line->a_id != -1)
+                by_a_id.emplace_back(line);
         }
     }
     auto by_edge_lower = [](const IntersectionLine* il1, const IntersectionLine *il2) { return il1->edge_a_id < il2->edge_a_id; };
@@ -1249,14 +1260,14 @@ static void chain_lines_by_triangle_connectivity(std::vector<IntersectionLine> &
     std::sort(by_edge_a_id.begin(), by_edge_a_id.end(), by_edge_lower);
     std::sort(by_a_id.begin(), by_a_id.end(), by_vertex_lower);
     // Chain the segments with a greedy algorithm, collect the loops and unclosed polylines.
-    IntersectionLines::iterator it_line_seed = lines.begin();
+    auto it_line_seed = lines.begin();
     for (;;) {
         // take first spare line and start a new loop
         IntersectionLine *first_line = nullptr;
         for (; it_line_seed != lines.end(); ++ it_line_seed)
-            if (it_line_seed->is_seed_candidate()) {
-            //if (! it_line_seed->skip()) {
-                first_line = &(*it_line_seed ++);
+            if ((*it_line_seed)->is_seed_candidate()) {
+            //if (! (*it_line_seed)->skip()) {
+                first_line = *it_line_seed ++;
                 break;
             }
         if (first_line == nullptr)
@@ -1330,6 +1341,106 @@ static void chain_lines_by_triangle_connectivity(std::vector<IntersectionLine> &
     }
 }
 
+// Layers with fewer lines than this are chained on a single thread, splitting them would cost more than it saves.
+static constexpr size_t CHAIN_LINES_PARALLEL_MIN = 20000;
+
+// called by TriangleMeshSlicer::make_loops() to connect sliced triangles into closed loops and open polylines by the triangle connectivity.
+// Only connects segments crossing triangles of the same orientation.
+// The greedy chaining only ever follows a shared mesh edge or a shared mesh vertex, therefore a huge layer is split
+// into the components connected by these references, which are chained in parallel.
+static void chain_lines_by_triangle_connectivity(std::vector<IntersectionLine> &lines, Polygons &loops, std::vector<OpenPolyline> &open_polylines)
+{
+    if (lines.size() < CHAIN_LINES_PARALLEL_MIN) {
+        IntersectionLinePtrs line_ptrs;
+        line_ptrs.reserve(lines.size());
+        for (IntersectionLine &line : lines)
+            line_ptrs.emplace_back(&line);
+        chain_lines_by_triangle_connectivity_serial(line_ptrs, loops, open_polylines);
+        return;
+    }
+
+    // Union-find over the line indices.
+    std::vector<int> parent(lines.size());
+    std::iota(parent.begin(), parent.end(), 0);
+    auto find_root = [&parent](int i) {
+        while (parent[i] != i)
+            i = parent[i] = parent[parent[i]];
+        return i;
+    };
+    // Keep the smallest line index as the root, so that the components are ordered by their first seed below.
+    auto unite = [&parent, &find_root](int i, int j) {
+        i = find_root(i);
+        j = find_root(j);
+        if (i < j)
+            parent[j] = i;
+        else if (j < i)
+            parent[i] = j;
+    };
+    // Join the lines sharing a mesh edge or a mesh vertex. Edge and vertex indices are separate index spaces.
+    std::vector<std::pair<int, int>> edge_refs;
+    std::vector<std::pair<int, int>> vertex_refs;
+    edge_refs.reserve(lines.size() * 2);
+    vertex_refs.reserve(lines.size() / 4);
+    for (int line_idx = 0; line_idx < int(lines.size()); ++ line_idx) {
+        const IntersectionLine &line = lines[line_idx];
+        if (line.skip())
+            continue;
+        if (line.edge_a_id != -1)
+            edge_refs.emplace_back(line.edge_a_id, line_idx);
+        if (line.edge_b_id != -1)
+            edge_refs.emplace_back(line.edge_b_id, line_idx);
+        if (line.a_id != -1)
+            vertex_refs.emplace_back(line.a_id, line_idx);
+        if (line.b_id != -1)
+            vertex_refs.emplace_back(line.b_id, line_idx);
+    }
+    for (std::vector<std::pair<int, int>> *refs : { &edge_refs, &vertex_refs }) {
+        tbb::parallel_sort(refs->begin(), refs->end());
+        for (size_t i = 1; i < refs->size(); ++ i)
+            if ((*refs)[i - 1].first == (*refs)[i].first)
+                unite((*refs)[i - 1].second, (*refs)[i].second);
+    }
+
+    // Collect the components in the order of their first line, each component keeping the order of its lines.
+    std::vector<int>                  component_of_root(lines.size(), -1);
+    std::vector<IntersectionLinePtrs> components;
+    for (int line_idx = 0; line_idx < int(lines.size()); ++ line_idx) {
+        if (lines[line_idx].skip())
+            continue;
+        int &component_idx = component_of_root[find_root(line_idx)];
+        if (component_idx == -1) {
+            component_idx = int(components.size());
+            components.emplace_back();
+        }
+        components[component_idx].emplace_back(&lines[line_idx]);
+    }
+
+    // Batch the small components, so that a task chains at least CHAIN_LINES_PARALLEL_MIN / 4 lines, unless a single component is larger.
+    std::vector<size_t> batches { 0 };
+    for (size_t i = 0, batch_lines = 0; i < components.size(); ++ i) {
+        batch_lines += components[i].size();
+        if (batch_lines >= CHAIN_LINES_PARALLEL_MIN / 4 || i + 1 == components.size()) {
+            batches.emplace_back(i + 1);
+            batch_lines = 0;
+        }
+    }
+
+    // Chain the batches in parallel, then merge their output in the batch order to stay deterministic.
+    std::vector<Polygons>                  batch_loops(batches.size() - 1);
+    std::vector<std::vector<OpenPolyline>> batch_open_polylines(batches.size() - 1);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, batches.size() - 1, 1),
+        [&batches, &components, &batch_loops, &batch_open_polylines](const tbb::blocked_range<size_t> &range) {
+            for (size_t batch_idx = range.begin(); batch_idx < range.end(); ++ batch_idx)
+                for (size_t i = batches[batch_idx]; i < batches[batch_idx + 1]; ++ i)
+                    chain_lines_by_triangle_connectivity_serial(components[i], batch_loops[batch_idx], batch_open_polylines[batch_idx]);
+        });
+    for (size_t batch_idx = 0; batch_idx + 1 < batches.size(); ++ batch_idx) {
+        append(loops, std::move(batch_loops[batch_idx]));
+        open_polylines.insert(open_polylines.end(),
+            std::make_move_iterator(batch_open_polylines[batch_idx].begin()), std::make_move_iterator(batch_open_polylines[batch_idx].end()));
+    }
+}
+
 std::vector<OpenPolyline*> open_polylines_sorted(std::vector<OpenPolyline> &open_polylines, bool update_lengths)
 {
     std::vector<OpenPolyline*> out;
@@ -39,6 +39,26 @@ public:
     }
 };
 
+namespace {
+
+mz_uint to_miniz_level(Zipper::e_compression compression)
+{
+    switch (compression) {
+    case Zipper::NO_COMPRESSION: return MZ_NO_COMPRESSION;
+    case Zipper::FAST_COMPRESSION: return MZ_BEST_SPEED;
+    case Zipper::TIGHT_COMPRESSION: return MZ_BEST_COMPRESSION;
+    }
+    return MZ_NO_COMPRESSION;
+}
+
+mz_bool append_to_string(const void *buf, int len, void *user)
+{
+    static_cast<std::string*>(user)->append(static_cast<const char*>(buf), size_t(len));
+    return MZ_TRUE;
+}
+
+} // namespace
+
 Zipper::Zipper(const std::string &zipfname, e_compression compression)
 {
     m_impl.reset(new Impl());
@@ -97,37 +117,56 @@ void Zipper::add_entry(const std::string &name, const void *data, size_t l)
     if(!m_impl->is_alive()) return;
 
     finish_entry();
-    mz_uint cmpr = MZ_NO_COMPRESSION;
-    switch (m_compression) {
-    case NO_COMPRESSION: cmpr = MZ_NO_COMPRESSION; break;
-    case FAST_COMPRESSION: cmpr = MZ_BEST_SPEED; break;
-    case TIGHT_COMPRESSION: cmpr = MZ_BEST_COMPRESSION; break;
-    }
 
-    if(!mz_zip_writer_add_mem(&m_impl->arch, name.c_str(), data, l, cmpr))
+    if(!mz_zip_writer_add_mem(&m_impl->arch, name.c_str(), data, l, to_miniz_level(m_compression)))
         m_impl->blow_up();
 
     m_entry.clear();
     m_data.clear();
 }
 
-void Zipper::finish_entry()
+Zipper::CompressedEntry Zipper::compress_entry(const std::string &name, const void *data, size_t l) const
+{
+    CompressedEntry entry;
+    entry.name              = name;
+    entry.uncompressed_size = l;
+    mz_uint level = to_miniz_level(m_compression);
+    // Tiny entries are stored by miniz anyway.
+    if (level != MZ_NO_COMPRESSION && l > 3) {
+        entry.crc = uint32_t(mz_crc32(MZ_CRC32_INIT, static_cast<const unsigned char*>(data), l));
+        // Raw deflate stream (negative window bits) with the same parameters miniz uses for the zip entries.
+        int flags = int(tdefl_create_comp_flags_from_zip_params(int(level), -MZ_DEFAULT_WINDOW_BITS, MZ_DEFAULT_STRATEGY));
+        entry.deflated = tdefl_compress_mem_to_output(data, l, append_to_string, &entry.data, flags) == MZ_TRUE;
+    }
+    if (! entry.deflated)
+        entry.data.assign(static_cast<const char*>(data), l);
+    return entry;
+}
+
+void Zipper::add_entry(const CompressedEntry &entry)
 {
     if(!m_impl->is_alive()) return;
 
-    if(!m_data.empty() && !m_entry.empty()) {
-        mz_uint compression = MZ_NO_COMPRESSION;
+    finish_entry();
 
-        switch (m_compression) {
-        case NO_COMPRESSION: compression = MZ_NO_COMPRESSION; break;
-        case FAST_COMPRESSION: compression = MZ_BEST_SPEED; break;
-        case TIGHT_COMPRESSION: compression = MZ_BEST_COMPRESSION; break;
-        }
+    mz_bool ok = entry.deflated ?
+        mz_zip_writer_add_mem_ex(&m_impl->arch, entry.name.c_str(), entry.data.data(), entry.data.size(), nullptr, 0,
+                                 to_miniz_level(m_compression) | MZ_ZIP_FLAG_COMPRESSED_DATA,
+                                 entry.uncompressed_size, entry.crc) :
+        mz_zip_writer_add_mem(&m_impl->arch, entry.name.c_str(), entry.data.data(), entry.data.size(), to_miniz_level(m_compression));
+    if(!ok)
+        m_impl->blow_up();
+}
+
+void Zipper::finish_entry()
+{
+    if(!m_impl->is_alive()) return;
 
+    if(!m_data.empty() && !m_entry.empty()) {
         if(!mz_zip_writer_add_mem(&m_impl->arch, m_entry.c_str(),
                                   m_data.c_str(),
                                   m_data.size(),
-                                  compression)) m_impl->blow_up();
+                                  to_miniz_level(m_compression))) m_impl->blow_up();
     }
 
     m_data.clear();
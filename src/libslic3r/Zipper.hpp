@@ -17,6 +17,17 @@ public:
         TIGHT_COMPRESSION
     };
 
+    // An entry compressed by compress_entry() outside of the archive,
+    // to be written into the archive by add_entry(const CompressedEntry&).
+    struct CompressedEntry {
+        std::string name;
+        // Raw deflate stream if deflated, the original bytes otherwise.
+        std::string data;
+        size_t      uncompressed_size = 0;
+        uint32_t    crc               = 0;
+        bool        deflated          = false;
+    };
+
 private:
     class Impl;
     std::unique_ptr<Impl> m_impl;
@@ -51,6 +62,16 @@ public:
     /// This method throws exactly like finish_entry() does.
     void add_entry(const std::string& name, const void* data, size_t bytes);
 
+    /// Compress a binary file entry with the compression level of this
+    /// archive without touching the archive itself. This method is thread
+    /// safe, thus the entries may be compressed in parallel and then added in
+    /// order by add_entry(const CompressedEntry&).
+    CompressedEntry compress_entry(const std::string& name, const void* data, size_t bytes) const;
+
+    /// Add an entry compressed by compress_entry().
+    /// This method throws exactly like finish_entry() does.
+    void add_entry(const CompressedEntry& entry);
+
     // Writing data to the archive works like with standard streams. The target
     // within the zip file is the entry created with the add_entry method.
 
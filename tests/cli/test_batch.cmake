@@ -0,0 +1,41 @@
+# Slices an FFF job configured by an ini file and a 3MF job without any config in a single --batch process.
+# The printer technology and the full config defaults are worked out per job, the --slice-cache
+# of the batch process is inherited by both jobs.
+#
+# cmake -DSLIC3R=<slicer executable> -DTEST_DATA_DIR=<tests/data> -DWORK_DIR=<scratch directory> -P test_batch.cmake
+
+foreach (_var SLIC3R TEST_DATA_DIR WORK_DIR)
+    if (NOT DEFINED ${_var})
+        message(FATAL_ERROR "${_var} is not defined")
+    endif ()
+endforeach ()
+
+file(REMOVE_RECURSE "${WORK_DIR}")
+file(MAKE_DIRECTORY "${WORK_DIR}")
+
+set(_jobs "${WORK_DIR}/jobs.txt")
+file(WRITE "${_jobs}"
+    "\"${TEST_DATA_DIR}/20mm_cube.obj\" --load \"${TEST_DATA_DIR}/test_cli/batch_fff.ini\" --output \"${WORK_DIR}/fff.gcode\"\n"
+    "\"${TEST_DATA_DIR}/test_3mf/Geräte/Büchse.3mf\" --output \"${WORK_DIR}/3mf.gcode\"\n"
+    "quit\n")
+
+execute_process(
+    COMMAND "${SLIC3R}" --batch --slice-cache "${WORK_DIR}/cache"
+    INPUT_FILE "${_jobs}"
+    RESULT_VARIABLE _result
+    OUTPUT_VARIABLE _output
+    ERROR_VARIABLE  _output)
+message("${_output}")
+
+if (NOT _result EQUAL 0)
+    message(FATAL_ERROR "--batch failed: ${_result}")
+endif ()
+foreach (_gcode fff.gcode 3mf.gcode)
+    if (NOT EXISTS "${WORK_DIR}/${_gcode}")
+        message(FATAL_ERROR "${_gcode} was not exported")
+    endif ()
+endforeach ()
+file(GLOB _cached "${WORK_DIR}/cache/*")
+if (NOT _cached)
+    message(FATAL_ERROR "the slice cache of the batch process was not used by the jobs")
+endif ()
@@ -1,8 +1,16 @@
 #include <catch2/catch.hpp>
 
 #include <memory>
+#include <sstream>
+
+#include <boost/filesystem.hpp>
+#include <boost/nowide/cstdio.hpp>
+#include <boost/nowide/fstream.hpp>
 
 #include "libslic3r/GCode.hpp"
+#include "libslic3r/GCodeReader.hpp"
+#include "libslic3r/GCode/GCodeProcessor.hpp"
+#include "libslic3r/GCode/SpiralVase.hpp"
 
 using namespace Slic3r;
 
@@ -20,3 +28,149 @@ SCENARIO("Origin manipulation", "[GCode]") {
     	}
     }
 }
+
+SCENARIO("GCodeReader parses a file like a buffer", "[GCode]") {
+	GIVEN("A G-code larger than the read block, with an unterminated last line") {
+		std::string gcode;
+		for (int i = 0; i < 100000; ++ i)
+			gcode += "G1 X" + std::to_string(i) + " Y" + std::to_string(i % 100) + " E0.1 ; comment\r\n\n";
+		gcode += "G1 Z10";
+		boost::filesystem::path temp = boost::filesystem::unique_path();
+		{
+			boost::nowide::ofstream f(temp.string(), std::ios::binary);
+			f << gcode;
+		}
+		WHEN("the file and the buffer are parsed") {
+			std::vector<std::string> from_file, from_buffer;
+			float                    x_file = 0, x_buffer = 0;
+			GCodeReader reader;
+			reader.parse_file(temp.string(), [&from_file](GCodeReader &, const GCodeReader::GCodeLine &line) { from_file.emplace_back(line.raw()); });
+			x_file = reader.x();
+			GCodeReader reader2;
+			reader2.parse_buffer(gcode, [&from_buffer](GCodeReader &, const GCodeReader::GCodeLine &line) { from_buffer.emplace_back(line.raw()); });
+			x_buffer = reader2.x();
+			std::vector<std::string> from_file_parallel;
+			GCodeReader reader3;
+			reader3.parse_file_parallel(temp.string(), [&from_file_parallel](GCodeReader &, const GCodeReader::GCodeLine &line) { from_file_parallel.emplace_back(line.raw()); });
+			THEN("the same lines are returned") {
+				REQUIRE(from_file.size() == 200001);
+				REQUIRE(from_file == from_buffer);
+				REQUIRE(from_file.back() == "G1 Z10");
+				REQUIRE(x_file == x_buffer);
+			}
+			THEN("the lines tokenized in parallel are returned in order") {
+				REQUIRE(from_file_parallel == from_buffer);
+				REQUIRE(reader3.x() == x_buffer);
+			}
+		}
+		boost::nowide::remove(temp.string().c_str());
+	}
+}
+
+SCENARIO("GCodeProcessor processes the G-code being exported like the exported file", "[GCode]") {
+	GIVEN("A few layers of G-code") {
+		std::string gcode = "G21\nG90\nM82\nG92 E0\nM106 S128\n";
+		for (int layer = 1; layer <= 20; ++ layer) {
+			gcode += ";" + GCodeProcessor::Layer_Change_Tag + "\n";
+			gcode += ";" + GCodeProcessor::Height_Tag + "0.2\n";
+			gcode += "G1 Z" + std::to_string(0.2 * layer) + " F7800\n";
+			gcode += ";" + GCodeProcessor::Extrusion_Role_Tag + ExtrusionEntity::role_to_string(erPerimeter) + "\n";
+			for (int i = 0; i < 200; ++ i)
+				gcode += "G1 X" + std::to_string(100 + 20 * std::cos(i * 0.0314)) + " Y" + std::to_string(100 + 20 * std::sin(i * 0.0314)) +
+					" E" + std::to_string(0.01 * (layer * 200 + i)) + " F1800 ; perimeter\n";
+			gcode += "G1 X90 Y90 F7800\n";
+		}
+		gcode += "M107";
+		boost::filesystem::path temp = boost::filesystem::unique_path();
+		{
+			boost::nowide::ofstream f(temp.string(), std::ios::binary);
+			f << gcode;
+		}
+		DynamicPrintConfig config = DynamicPrintConfig::full_print_config();
+		WHEN("the G-code is processed in pieces splitting its lines, and from the file") {
+			GCodeProcessor incremental;
+			incremental.apply_config(config);
+			incremental.initialize();
+			for (size_t i = 0; i < gcode.size(); i += 1001)
+				incremental.process_buffer(gcode.substr(i, 1001));
+			incremental.finalize(temp.string(), false);
+			GCodeProcessor from_file;
+			from_file.apply_config(config);
+			from_file.process_file(temp.string(), false);
+			THEN("the moves are the same") {
+				const std::vector<GCodeProcessor::MoveVertex> &moves      = incremental.get_result().moves;
+				const std::vector<GCodeProcessor::MoveVertex> &file_moves = from_file.get_result().moves;
+				REQUIRE(moves.size() > 20 * 200);
+				REQUIRE(moves.size() == file_moves.size());
+				for (size_t i = 0; i < moves.size(); ++ i) {
+					REQUIRE(moves[i].type == file_moves[i].type);
+					REQUIRE(moves[i].extrusion_role == file_moves[i].extrusion_role);
+					REQUIRE(moves[i].position == file_moves[i].position);
+					REQUIRE(moves[i].delta_extruder == file_moves[i].delta_extruder);
+					REQUIRE(moves[i].feedrate == file_moves[i].feedrate);
+					REQUIRE(moves[i].fan_speed == file_moves[i].fan_speed);
+					REQUIRE(moves[i].layer_duration == file_moves[i].layer_duration);
+					REQUIRE(moves[i].time == file_moves[i].time);
+				}
+			}
+			THEN("the time estimates are the same") {
+				REQUIRE(incremental.get_time(PrintEstimatedTimeStatistics::ETimeMode::Normal) > 0.f);
+				REQUIRE(incremental.get_time(PrintEstimatedTimeStatistics::ETimeMode::Normal) == from_file.get_time(PrintEstimatedTimeStatistics::ETimeMode::Normal));
+				REQUIRE(incremental.get_time(PrintEstimatedTimeStatistics::ETimeMode::Stealth) == from_file.get_time(PrintEstimatedTimeStatistics::ETimeMode::Stealth));
+				REQUIRE(incremental.get_moves_time(PrintEstimatedTimeStatistics::ETimeMode::Normal) == from_file.get_moves_time(PrintEstimatedTimeStatistics::ETimeMode::Normal));
+			}
+		}
+		boost::nowide::remove(temp.string().c_str());
+	}
+}
+
+SCENARIO("Spiral vase ramps Z continuously across the layer changes", "[GCode]") {
+	GIVEN("Square loops of 0.2mm layers with relative extruder distances") {
+		PrintConfig config;
+		config.use_relative_e_distances.value = true;
+		SpiralVase  spiral_vase(config);
+		auto layer = [](float z) {
+			std::ostringstream ss;
+			ss << "G1 Z" << z << " F600\n"
+					"G1 X10 Y0 E1\n"
+					"G1 X10 Y10 E1\n"
+					"G1 X0 Y10 E1\n"
+					"G1 X0 Y0 E1\n";
+			return ss.str();
+		};
+		WHEN("the first layer is printed normally and the next two are spiralized") {
+			std::string gcode;
+			spiral_vase.enable(false);
+			gcode += spiral_vase.process_layer(layer(0.2f));
+			spiral_vase.enable(true);
+			gcode += spiral_vase.process_layer(layer(0.4f));
+			spiral_vase.enable(true);
+			gcode += spiral_vase.process_layer(layer(0.6f));
+			std::vector<float> z;
+			std::vector<float> e;
+			GCodeReader reader;
+			reader.parse_buffer(gcode, [&z, &e](GCodeReader &, const GCodeReader::GCodeLine &line) {
+				if (line.has_z())
+					z.emplace_back(line.z());
+				if (line.has_e())
+					e.emplace_back(line.e());
+			});
+			THEN("each spiral layer starts at the top of the previous layer and rises to its own top") {
+				const std::vector<float> expected { 0.2f,
+					0.2f, 0.25f, 0.3f, 0.35f, 0.4f,
+					0.4f, 0.45f, 0.5f, 0.55f, 0.6f };
+				REQUIRE(z.size() == expected.size());
+				for (size_t i = 0; i < z.size(); ++ i)
+					REQUIRE(z[i] == Approx(expected[i]));
+			}
+			THEN("the extrusion is ramped up over the first spiral layer only") {
+				const std::vector<float> expected { 1.f, 1.f, 1.f, 1.f,
+					0.25f, 0.5f, 0.75f, 1.f,
+					1.f, 1.f, 1.f, 1.f };
+				REQUIRE(e.size() == expected.size());
+				for (size_t i = 0; i < e.size(); ++ i)
+					REQUIRE(e[i] == Approx(expected[i]));
+			}
+		}
+	}
+}
@@ -1,5 +1,7 @@
 #include <catch2/catch.hpp>
 
+#include <mutex>
+
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
@@ -138,3 +140,29 @@ SCENARIO("Print: Brim generation", "[Print]") {
         }
     }
 }
+
+SCENARIO("Print: the progress of objects processed concurrently never decreases", "[Print]") {
+    GIVEN("four objects with support material") {
+        Slic3r::Print print;
+        Slic3r::Model model;
+        Slic3r::Test::init_print({ TestMesh::cube_20x20x20, TestMesh::overhang, TestMesh::pyramid, TestMesh::V }, print, model, {
+            { "support_material", 1 },
+            { "layer_height",     0.2 }
+            });
+        std::mutex       mutex;
+        std::vector<int> percents;
+        print.set_status_callback([&mutex, &percents](const PrintBase::SlicingStatus &status) {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (status.percent >= 0)
+                percents.emplace_back(status.percent);
+        });
+        WHEN("the print is processed") {
+            print.process();
+            THEN("the reported progress never goes back") {
+                REQUIRE(percents.size() > 4);
+                for (size_t i = 1; i < percents.size(); ++ i)
+                    REQUIRE(percents[i - 1] <= percents[i]);
+            }
+        }
+    }
+}
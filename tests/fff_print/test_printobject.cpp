@@ -3,6 +3,12 @@
 #include "libslic3r/libslic3r.h"
 #include "libslic3r/Print.hpp"
 #include "libslic3r/Layer.hpp"
+#include "libslic3r/SliceCache.hpp"
+
+#include <boost/algorithm/string/predicate.hpp>
+#include <boost/filesystem.hpp>
+
+#include <sstream>
 
 #include "test_data.hpp"
 
@@ -299,3 +305,88 @@ SCENARIO("PrintObject: minimum horizontal shells", "[PrintObject]") {
 
     }
 }
+
+SCENARIO("PrintObject: slice cache", "[PrintObject]") {
+    GIVEN("20mm cube and a slice cache in a temporary directory") {
+        boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        auto cache = std::make_shared<SliceCache>(dir.string());
+        auto slice = [&cache](int fill_density) {
+            Slic3r::Print print;
+            Slic3r::Model model;
+            print.set_slice_cache(cache);
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, {
+                { "layer_height",   0.2 },
+                { "fill_density",   fill_density },
+            });
+            print.process();
+            std::vector<ExPolygons> lslices;
+            std::vector<bool>       slicing_errors;
+            std::vector<coordf_t>   print_z;
+            for (const Layer *layer : print.objects().front()->layers()) {
+                lslices.emplace_back(layer->lslices);
+                slicing_errors.emplace_back(layer->slicing_errors);
+                print_z.emplace_back(layer->print_z);
+            }
+            return std::make_tuple(lslices, slicing_errors, print_z);
+        };
+        WHEN("the cube is sliced twice with a different infill") {
+            auto [sliced, sliced_errors, sliced_z] = slice(20);
+            size_t num_entries = std::distance(boost::filesystem::directory_iterator(dir), boost::filesystem::directory_iterator());
+            auto [loaded, loaded_errors, loaded_z] = slice(40);
+            THEN("the slices are stored once and loaded unchanged") {
+                // The slices and the state after the support generation.
+                REQUIRE(num_entries == 2);
+                // The state is stored again for the other infill, the slices are reused.
+                REQUIRE(std::distance(boost::filesystem::directory_iterator(dir), boost::filesystem::directory_iterator()) == 3);
+                REQUIRE(loaded.size() == sliced.size());
+                for (size_t i = 0; i < sliced.size(); ++ i) {
+                    REQUIRE(loaded[i].size() == sliced[i].size());
+                    for (size_t j = 0; j < sliced[i].size(); ++ j)
+                        REQUIRE(loaded[i][j].contour.points == sliced[i][j].contour.points);
+                }
+            }
+            THEN("the layers and their slicing errors are restored") {
+                REQUIRE(loaded_z == sliced_z);
+                REQUIRE(loaded_errors == sliced_errors);
+            }
+        }
+        boost::filesystem::remove_all(dir);
+    }
+}
+
+SCENARIO("PrintObject: cached state", "[PrintObject]") {
+    GIVEN("20mm cube with supports and a slice cache in a temporary directory") {
+        boost::filesystem::path dir = boost::filesystem::temp_directory_path() / boost::filesystem::unique_path();
+        auto cache = std::make_shared<SliceCache>(dir.string());
+        auto export_gcode = [&cache](int temperature) {
+            Slic3r::Print print;
+            Slic3r::Model model;
+            print.set_slice_cache(cache);
+            Slic3r::Test::init_print({TestMesh::cube_20x20x20}, print, model, {
+                { "support_material", true },
+                { "temperature",      temperature },
+            });
+            print.process();
+            // Only compare the moves, the header holds the time of the export.
+            std::string moves;
+            std::istringstream gcode(Slic3r::Test::gcode(print));
+            for (std::string line; std::getline(gcode, line);)
+                if (boost::starts_with(line, "G1 "))
+                    moves += line + "\n";
+            return moves;
+        };
+        WHEN("the cube is exported twice with a different temperature") {
+            std::string moves1 = export_gcode(200);
+            size_t      num_entries = std::distance(boost::filesystem::directory_iterator(dir), boost::filesystem::directory_iterator());
+            std::string moves2 = export_gcode(210);
+            THEN("the second export loads the same extrusions from the cache") {
+                // One entry for the slices, one for the state after the support generation.
+                REQUIRE(num_entries == 2);
+                REQUIRE(std::distance(boost::filesystem::directory_iterator(dir), boost::filesystem::directory_iterator()) == 2);
+                REQUIRE(! moves1.empty());
+                REQUIRE(moves1 == moves2);
+            }
+        }
+        boost::filesystem::remove_all(dir);
+    }
+}
@@ -226,6 +226,25 @@ SCENARIO( "TriangleMesh: slice behavior.") {
             }
         }
     }
+    GIVEN( "Four high-poly cylinders side by side") {
+        TriangleMesh mesh;
+        for (int i = 0; i < 4; ++ i) {
+            TriangleMesh cyl = make_cylinder(10, 10, 2 * PI / 8000);
+            cyl.translate(25.f * float(i), 0.f, 0.f);
+            mesh.merge(cyl);
+        }
+        mesh.repair();
+        WHEN("The mesh is sliced through a layer with enough lines to be chained in parallel") {
+            std::vector<ExPolygons> slices = mesh.slice({ 5.0 });
+            THEN( "Each cylinder produces one closed contour of the right area") {
+                REQUIRE(slices.at(0).size() == 4);
+                for (const ExPolygon &expoly : slices.at(0)) {
+                    REQUIRE(expoly.holes.empty());
+                    REQUIRE(std::abs(expoly.area() * SCALING_FACTOR * SCALING_FACTOR - M_PI * 100.) < 0.1);
+                }
+            }
+        }
+    }
 }
 
 SCENARIO( "make_xxx functions produce meshes.") {
@@ -2,8 +2,10 @@
 
 #include <fstream>
 #include <cstdint>
+#include <iostream>
 
 #include <libnest2d/libnest2d.hpp>
+#include <libnest2d/tools/benchmark.h>
 #include "printer_parts.hpp"
 //#include <libnest2d/geometry_traits_nfp.hpp>
 #include "../tools/svgtools.hpp"
@@ -611,6 +613,78 @@ TEST_CASE("PrusaPartsShouldFitIntoTwoBins", "[Nesting]") {
     }
 }
 
+TEST_CASE("ParallelNestingIsReproducible", "[Nesting]") {
+    auto bin = Box(250000000, 210000000);
+
+    std::vector<Item> input_serial   = prusaParts();
+    std::vector<Item> input_parallel = prusaParts();
+
+    NestConfig<> cfg_serial;
+    cfg_serial.placer_config.parallel = false;
+    NestConfig<> cfg_parallel;
+    cfg_parallel.placer_config.parallel = true;
+
+    size_t bins_serial   = libnest2d::nest(input_serial, bin, 0, cfg_serial);
+    size_t bins_parallel = libnest2d::nest(input_parallel, bin, 0, cfg_parallel);
+
+    // The parallel evaluation of the starting points shall not change the
+    // result, the items shall land at the very same positions.
+    REQUIRE(bins_serial == bins_parallel);
+    for (size_t i = 0; i < input_serial.size(); ++i) {
+        REQUIRE(input_serial[i].binId() == input_parallel[i].binId());
+        REQUIRE(input_serial[i].translation() == input_parallel[i].translation());
+        REQUIRE(double(input_serial[i].rotation()) == Approx(double(input_parallel[i].rotation())));
+    }
+}
+
+TEST_CASE("NfpCacheIsSharedByCopies", "[Nesting]") {
+    auto bin = Box(250000000, 210000000);
+
+    std::vector<Item> input(20, RectangleItem{20000000, 10000000});
+
+    NestConfig<> cfg;
+    cfg.placer_config.nfp_cache = std::make_shared<placers::NfpCache<PolygonImpl>>();
+
+    size_t bins = libnest2d::nest(input, bin, 0, cfg);
+
+    REQUIRE(bins == 1);
+    // A single shape in four rotations makes at most 4 x 4 different pairs.
+    REQUIRE(cfg.placer_config.nfp_cache->size() > 0);
+    REQUIRE(cfg.placer_config.nfp_cache->size() <= 16);
+
+    // The nfps cached by the first nesting give the very same result.
+    std::vector<Item> input2(20, RectangleItem{20000000, 10000000});
+    libnest2d::nest(input2, bin, 0, cfg);
+    for (size_t i = 0; i < input.size(); ++i) {
+        REQUIRE(input[i].binId() == input2[i].binId());
+        REQUIRE(input[i].translation() == input2[i].translation());
+    }
+}
+
+// Not run by default, invoke the tests with [Benchmark] to track the arrange time against the item count.
+TEST_CASE("ArrangeTimeAgainstItemCount", "[Nesting][.][Benchmark]") {
+    auto bin = Box(250000000, 210000000);
+
+    for (size_t count : {50, 100, 200, 400}) {
+        std::vector<Item> input;
+        input.reserve(count);
+        while (input.size() < count)
+            input.emplace_back(prusaParts()[input.size() % prusaParts().size()]);
+
+        Benchmark bench;
+        bench.start();
+        size_t bins = libnest2d::nest(input, bin);
+        bench.stop();
+
+        std::cout << "Nesting " << count << " items into " << bins
+                  << " bins took " << bench.getElapsedSec() << " s" << std::endl;
+
+        REQUIRE(std::all_of(input.begin(), input.end(), [](const Item &itm) {
+            return itm.binId() != BIN_ID_UNSET;
+        }));
+    }
+}
+
 TEST_CASE("EmptyItemShouldBeUntouched", "[Nesting]") {
     auto bin = Box(250000000, 210000000); // dummy bin
 
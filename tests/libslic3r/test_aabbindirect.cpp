@@ -59,3 +59,49 @@ TEST_CASE("Building a tree over a box, ray caster and closest query", "[AABBIndi
     REQUIRE(closest_point.y() == Approx(0.5));
     REQUIRE(closest_point.z() == Approx(1.));
 }
+
+TEST_CASE("Ray packets hit the same as single rays", "[AABBIndirect]")
+{
+    TriangleMesh tmesh = make_sphere(1., PI / 16.);
+    tmesh.repair();
+
+    auto tree = AABBTreeIndirect::build_aabb_tree_over_indexed_triangle_set(tmesh.its.vertices, tmesh.its.indices);
+    REQUIRE(! tree.empty());
+
+    // Fans of rays from below the sphere, from its inside and from a source they miss the sphere from,
+    // not a multiple of the packet size to exercise the partial packet.
+    std::vector<Vec3d> sources, dirs;
+    for (const Vec3d &src : { Vec3d(0., 0., -3.), Vec3d(0.2, 0.1, 0.), Vec3d(2., 2., 2.) })
+        for (int i = 0; i < 13; ++ i) {
+            double phi = 2. * PI * i / 13.;
+            sources.emplace_back(src);
+            dirs.emplace_back(Vec3d(0.3 * std::cos(phi), 0.3 * std::sin(phi), 1.).normalized());
+        }
+
+    std::vector<igl::Hit> hits(sources.size());
+    AABBTreeIndirect::intersect_rays_first_hit(
+        tmesh.its.vertices, tmesh.its.indices,
+        tree,
+        sources.data(), dirs.data(), sources.size(),
+        hits.data());
+
+    size_t num_hits = 0;
+    for (size_t i = 0; i < sources.size(); ++ i) {
+        igl::Hit hit;
+        bool intersected = AABBTreeIndirect::intersect_ray_first_hit(
+            tmesh.its.vertices, tmesh.its.indices,
+            tree,
+            sources[i], dirs[i],
+            hit);
+        REQUIRE(intersected == (hits[i].id >= 0));
+        if (intersected) {
+            ++ num_hits;
+            REQUIRE(hits[i].id == hit.id);
+            REQUIRE(hits[i].t == hit.t);
+            REQUIRE(hits[i].u == hit.u);
+            REQUIRE(hits[i].v == hit.v);
+        } else
+            REQUIRE(std::isinf(hits[i].t));
+    }
+    REQUIRE(num_hits == 26);
+}
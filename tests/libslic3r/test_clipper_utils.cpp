@@ -246,6 +246,71 @@ SCENARIO("Various Clipper operations - t/clipper.t", "[ClipperUtils]") {
             }
         }
     }
+    GIVEN("a row of squares and a row of smaller squares overlapping the first two") {
+        ExPolygons squares, small_squares;
+        for (int i = 0; i < 5; ++ i) {
+            squares.emplace_back(Slic3r::Polygon { { 100 * i, 0 }, { 100 * i + 50, 0 }, { 100 * i + 50, 50 }, { 100 * i, 50 } });
+            small_squares.emplace_back(Slic3r::Polygon { { 100 * i + 40, 10 }, { 100 * i + 60, 10 }, { 100 * i + 60, 30 }, { 100 * i + 40, 30 } });
+        }
+        small_squares.resize(2);
+        auto area = [](const ExPolygons &expolys) {
+            return std::accumulate(expolys.begin(), expolys.end(), 0., [](double a, const ExPolygon &p) { return a + p.area(); });
+        };
+        WHEN("diff_ex_clipped") {
+            ExPolygons diff = Slic3r::diff_ex_clipped(squares, small_squares);
+            THEN("it matches diff_ex") {
+                REQUIRE(diff.size() == 5);
+                REQUIRE(area(diff) == Approx(area(Slic3r::diff_ex(squares, small_squares))));
+            }
+        }
+        WHEN("intersection_ex_clipped") {
+            ExPolygons intersection = Slic3r::intersection_ex_clipped(squares, small_squares);
+            THEN("it matches intersection_ex") {
+                REQUIRE(intersection.size() == 2);
+                REQUIRE(area(intersection) == Approx(area(Slic3r::intersection_ex(squares, small_squares))));
+            }
+        }
+        WHEN("intersection_ex_clipped with Polygons not touching the subject") {
+            Polygons far_square { Slic3r::Polygon { { 1000, 1000 }, { 1010, 1000 }, { 1010, 1010 }, { 1000, 1010 } } };
+            THEN("it is empty") {
+                REQUIRE(Slic3r::intersection_ex_clipped(to_polygons(squares), far_square).empty());
+            }
+        }
+    }
+    GIVEN("islands far from the clip polygon: overlapping squares, a sliver and a square with a sliver hole") {
+        auto square = [](double x, double y, double size) {
+            return Slic3r::Polygon { Point::new_scale(x, y), Point::new_scale(x + size, y), Point::new_scale(x + size, y + size), Point::new_scale(x, y + size) };
+        };
+        ExPolygons subject;
+        subject.emplace_back(square(0, 0, 10));
+        subject.emplace_back(square(100, 0, 10));
+        subject.emplace_back(square(105, 5, 10));
+        subject.emplace_back(Slic3r::Polygon { Point::new_scale(200, 0), Point::new_scale(210, 0), Point::new_scale(210, 0.00001), Point::new_scale(200, 0.00001) });
+        subject.emplace_back(square(300, 0, 10));
+        subject.back().holes.emplace_back(Slic3r::Polygon { Point::new_scale(301, 5), Point::new_scale(301, 5.00001), Point::new_scale(309, 5.00001), Point::new_scale(309, 5) });
+        ExPolygons clip { ExPolygon(square(5, 5, 10)) };
+        auto area = [](const ExPolygons &expolys) {
+            return std::accumulate(expolys.begin(), expolys.end(), 0., [](double a, const ExPolygon &p) { return a + p.area(); });
+        };
+        WHEN("diff_ex_clipped with the safety offset") {
+            ExPolygons diff     = Slic3r::diff_ex_clipped(subject, clip, true);
+            ExPolygons expected = Slic3r::diff_ex(subject, clip, true);
+            THEN("it matches diff_ex") {
+                REQUIRE(diff.size() == expected.size());
+                REQUIRE(diff.size() == 3);
+                REQUIRE(area(diff) == Approx(area(expected)));
+                size_t num_holes = 0;
+                for (const ExPolygon &expoly : diff)
+                    num_holes += expoly.holes.size();
+                REQUIRE(num_holes == 0);
+            }
+        }
+        WHEN("intersection_ex_clipped with the safety offset") {
+            THEN("it matches intersection_ex") {
+                REQUIRE(area(Slic3r::intersection_ex_clipped(subject, clip, true)) == Approx(area(Slic3r::intersection_ex(subject, clip, true))));
+            }
+        }
+    }
 }
 
 template<e_ordering o = e_ordering::OFF, class P, class Tree> 
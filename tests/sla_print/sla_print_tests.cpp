@@ -2,11 +2,17 @@
 #include <unordered_map>
 #include <random>
 #include <cstdint>
+#include <cstring>
 
 #include "sla_test_utils.hpp"
 
 #include <libslic3r/SLA/SupportTreeMesher.hpp>
 #include <libslic3r/SLA/Concurrency.hpp>
+#include <libslic3r/SLA/RLERaster.hpp>
+#include <libslic3r/Format/SLAArchive.hpp>
+#include <libslic3r/miniz_extension.hpp>
+
+#include <boost/filesystem.hpp>
 
 namespace {
 
@@ -224,6 +230,123 @@ TEST_CASE("RasterizedPolygonAreaShouldMatch", "[SLARasterOutput]") {
     REQUIRE(raster_pxsum(raster0) == 0);
 }
 
+TEST_CASE("RLERasterShouldMatchDenseRaster", "[SLARasterOutput]") {
+    double disp_w = 120., disp_h = 68.;
+    sla::RasterBase::Resolution res{2560, 1440};
+    sla::RasterBase::PixelDim pixdim{disp_w / res.width_px, disp_h / res.height_px};
+    auto bb = BoundingBox({0, 0}, {scaled(disp_w), scaled(disp_h)});
+    
+    // Overlapping polygons, one of them reaching out of the display.
+    ExPolygons polys(3);
+    polys[0] = square_with_hole(10.);
+    polys[0].translate(bb.center().x(), bb.center().y());
+    polys[1] = square_with_hole(30.);
+    polys[1].rotate(0.3);
+    polys[1].translate(bb.center().x() + scaled(5.), bb.center().y() + scaled(3.));
+    polys[2] = square_with_hole(40.);
+    polys[2].rotate(-0.2);
+    
+    for (double gamma : {1., 2.2}) {
+        sla::RasterBase::Trafo trafo{sla::RasterBase::roLandscape, sla::RasterBase::MirrorX};
+        sla::RasterGrayscaleAAGammaPower raster(res, pixdim, trafo, gamma);
+        sla::RLERasterGrayscaleAA rle(res, pixdim, trafo, agg::gamma_power(gamma));
+        for (const ExPolygon &poly : polys) {
+            raster.draw(poly);
+            rle.draw(poly);
+        }
+        
+        size_t mismatches = 0;
+        for (size_t y = 0; y < res.height_px; ++y)
+            for (size_t x = 0; x < res.width_px; ++x)
+                mismatches += raster.read_pixel(x, y) != rle.read_pixel(x, y);
+        REQUIRE(mismatches == 0);
+        
+        sla::EncodedRaster png = raster.encode(sla::PNGRasterEncoder());
+        sla::EncodedRaster rle_png = rle.encode(sla::PNGRasterEncoder());
+        REQUIRE(rle_png.size() == png.size());
+        REQUIRE(std::memcmp(rle_png.data(), png.data(), png.size()) == 0);
+        
+        rle.clear();
+        REQUIRE(rle.row(res.height_px / 2).empty());
+    }
+}
+
+namespace {
+
+// Writes the given layers into a zip through SLAArchive::export_layers().
+class TestLayersArchive: public SLAArchive {
+    SLAPrinterConfig m_cfg;
+
+protected:
+    SLAPrinterConfig& config() override { return m_cfg; }
+    const SLAPrinterConfig& config() const override { return m_cfg; }
+
+public:
+    TestLayersArchive(std::vector<sla::EncodedRaster> &&layers, size_t max_layers_in_flight)
+        : SLAArchive(max_layers_in_flight)
+    {
+        m_layers = std::move(layers);
+    }
+
+    void export_print(Zipper &zipper, const SLAPrint &, const std::string &projectname) override
+    {
+        export_layers(zipper, projectname);
+    }
+
+    void export_layers(Zipper &zipper, const std::string &projectname) const
+    {
+        SLAArchive::export_layers(zipper, projectname);
+    }
+};
+
+} // namespace
+
+TEST_CASE("SLA archive layers compressed in batches are stored in order", "[SLARasterOutput]")
+{
+    // Layers of different sizes and compressibility, more than a few batches of them.
+    std::mt19937 rng(42);
+    std::vector<std::vector<uint8_t>> layers(23);
+    for (size_t i = 0; i < layers.size(); ++i) {
+        layers[i].resize(1000 + 5000 * (i % 4));
+        for (size_t j = 0; j < layers[i].size(); ++j)
+            layers[i][j] = (i % 2) ? uint8_t(rng()) : uint8_t(j / 100);
+    }
+    // A layer too small to be deflated.
+    layers[5] = {1, 2};
+
+    for (Zipper::e_compression level : {Zipper::NO_COMPRESSION, Zipper::FAST_COMPRESSION, Zipper::TIGHT_COMPRESSION}) {
+        std::vector<sla::EncodedRaster> encoded;
+        for (const std::vector<uint8_t> &layer : layers)
+            encoded.emplace_back(std::vector<uint8_t>(layer), "png");
+
+        std::string zipfname = (boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("sla_layers_%%%%-%%%%.zip")).string();
+        {
+            Zipper zipper(zipfname, level);
+            TestLayersArchive archive(std::move(encoded), 4);
+            REQUIRE(archive.max_layers_in_flight() == 4);
+            archive.export_layers(zipper, "layer");
+            zipper.finalize();
+        }
+
+        MZ_Archive zip;
+        REQUIRE(open_zip_reader(&zip.arch, zipfname));
+        REQUIRE(mz_zip_reader_get_num_files(&zip.arch) == layers.size());
+        for (size_t i = 0; i < layers.size(); ++i) {
+            char name[32];
+            sprintf(name, "layer%.5d.png", int(i));
+            REQUIRE(mz_zip_reader_locate_file(&zip.arch, name, nullptr, 0) == int(i));
+            size_t size = 0;
+            void  *data = mz_zip_reader_extract_to_heap(&zip.arch, mz_uint(i), &size, 0);
+            REQUIRE(data != nullptr);
+            REQUIRE(size == layers[i].size());
+            REQUIRE(std::memcmp(data, layers[i].data(), size) == 0);
+            mz_free(data);
+        }
+        close_zip_reader(&zip.arch);
+        boost::filesystem::remove(zipfname);
+    }
+}
+
 TEST_CASE("Triangle mesh conversions should be correct", "[SLAConversions]")
 {
     sla::Contour3D cntr;